@@ -0,0 +1,503 @@
+/**
+ *	CoolBoardBenchmark
+ *
+ *	This example measures each stage of the DOM based
+ *	telemetry encoding pipeline: DOM build, msgpack
+ *	sizing, msgpack encoding and Z85 encoding. The
+ *	streaming CoolTelemetry writer and CoolZ85 encoder
+ *	used by CoolBoard replace all four stages and are
+ *	measured together as the "stream" stage.
+ *
+ *	Payloads are synthetic. The WeatherStation layout
+ *	follows its sensors.json. The Farm, Station and
+ *	AutoSprinkle examples still ship the older
+ *	coolBoardSensorsConfig.json, externalSensorsConfig.json,
+ *	irene3000Config.json and jetPackConfig.json files: their
+ *	layouts are those files translated by hand into the
+ *	keys the current firmware logs. The one wire sensor has
+ *	no key there, so "DallasTemperature_1" is made up, and
+ *	all the values are made up too. For every stage the
+ *	serial output reports the time per message in
+ *	microseconds and the heap held once the stage is done.
+ *	The "held" line is the most heap the DOM pipeline held
+ *	at once between stages, once the DOM, msgpack and Z85
+ *	buffers are all alive. Allocations released within a
+ *	stage are not seen, so it is a lower bound of the
+ *	pipeline peak. The "write" stage is
+ *	the allocation free CoolMessagePack::writeJson()
+ *	encoder, and every payload is checked to encode to
+ *	the same bytes through jsonToMsgpck(), writeJson()
+ *	and CoolTelemetry. The Z85 text of every payload is
+ *	also decoded back with the backlog decoder, and must
+ *	give the raw msgpack bytes sent by the binary
+ *	transport. Up to eight copies of each payload are
+ *	then compressed into a backlog block and expanded
+ *	back. Last, the streaming writer is timed with text
+ *	keys, as before compact keys, and with the integer
+ *	IDs of CoolSchema. Only the fixed keys have IDs here,
+ *	since /sensors.json is not read.
+ *
+ *	A second run adds up to EXTERNAL_SENSORS_MAX external
+ *	sensors to the WeatherStation layout and reports the
+ *	msgpack sizing and encoding time per field, which
+ *	should stay flat as the payload grows.
+ *
+ *	A last run writes a CONFIG_FILE_SIZE bytes actuators
+ *	configuration to the SPIFFS and parses it both from
+ *	a String copy of the file, as older versions did, and
+ *	with the CoolConfig stream reader, then reports the
+ *	time of each and the heap held once the file is
+ *	parsed, the String copy included.
+ *
+ *	Build it with:
+ *	PLATFORMIO_SRC_DIR=examples/Benchmark pio run -t upload
+ *
+ */
+
+#include <CoolBoard.h>
+
+#define BENCHMARK_ITERATIONS 100
+#define EXTERNAL_SENSORS_MAX 10
+#define CONFIG_FILE_SIZE 16384
+#define CONFIG_FILE_PATH "/benchmark.json"
+#define ACTUATOR_FORMAT                                                        \
+  "%s{\"actif\":true,\"temporal\":false,\"inverted\":false,"                   \
+  "\"sensor\":\"Temperature_%d\",\"type\":\"\",\"low\":{\"range\":%d.5,"       \
+  "\"time\":0,\"hour\":6,\"minute\":30},\"high\":{\"range\":%d.5,"             \
+  "\"time\":0,\"hour\":20,\"minute\":0}}"
+
+struct Payload {
+  const char *name;
+  const char *sensors;
+  uint8_t actuators;
+};
+
+const Payload payloads[] = {
+    {"WeatherStation",
+     "{\"sensors\":["
+     "{\"key\":\"BME280_1\",\"measures\":"
+     "[\"temperature\",\"humidity\",\"pressure\"]},"
+     "{\"key\":\"SI114X_1\",\"measures\":"
+     "[\"visibleLight\",\"infrared\",\"ultraviolet\"]},"
+     "{\"key\":\"soilMoisture_1\",\"measures\":[\"soilMoisture\"]}]}",
+     0},
+    {"Farm",
+     "{\"sensors\":["
+     "{\"key\":\"BME280_1\",\"measures\":"
+     "[\"temperature\",\"humidity\",\"pressure\"]},"
+     "{\"key\":\"SI114X_1\",\"measures\":"
+     "[\"visibleLight\",\"infrared\",\"ultraviolet\"]},"
+     "{\"key\":\"soilMoisture_1\",\"measures\":[\"soilMoisture\"]},"
+     "{\"key\":\"DallasTemperature_1\",\"measures\":[\"TempOneWire\"]},"
+     "{\"key\":\"PT1000\",\"measures\":[\"waterTemp\"]},"
+     "{\"key\":\"phProbe\",\"measures\":[\"ph\"]},"
+     "{\"key\":\"adc2\",\"measures\":[\"voltage\"]}]}",
+     8},
+    {"Station",
+     "{\"sensors\":["
+     "{\"key\":\"BME280_1\",\"measures\":"
+     "[\"temperature\",\"humidity\",\"pressure\"]},"
+     "{\"key\":\"SI114X_1\",\"measures\":"
+     "[\"visibleLight\",\"infrared\",\"ultraviolet\"]},"
+     "{\"key\":\"soilMoisture_1\",\"measures\":[\"soilMoisture\"]},"
+     "{\"key\":\"DallasTemperature_1\",\"measures\":[\"TempOneWire\"]},"
+     "{\"key\":\"PT1000\",\"measures\":[\"waterTemp\"]},"
+     "{\"key\":\"phProbe\",\"measures\":[\"ph\"]}]}",
+     8},
+    {"AutoSprinkle",
+     "{\"sensors\":["
+     "{\"key\":\"BME280_1\",\"measures\":"
+     "[\"temperature\",\"humidity\",\"pressure\"]},"
+     "{\"key\":\"SI114X_1\",\"measures\":"
+     "[\"visibleLight\",\"infrared\",\"ultraviolet\"]},"
+     "{\"key\":\"soilMoisture_1\",\"measures\":[\"soilMoisture\"]},"
+     "{\"key\":\"PT1000\",\"measures\":[\"waterTemp\"]},"
+     "{\"key\":\"phProbe\",\"measures\":[\"ph\"]},"
+     "{\"key\":\"adc2\",\"measures\":[\"waterLevel\"]}]}",
+     8}};
+
+struct Stage {
+  const char *name;
+  unsigned long time;
+  uint32_t heap;
+};
+
+enum {
+  STAGE_DOM,
+  STAGE_SIZE,
+  STAGE_MSGPACK,
+  STAGE_Z85,
+  STAGE_WRITE,
+  STAGE_STREAM,
+  STAGE_COUNT
+};
+
+void fillLog(JsonObject &root, JsonArray &sensors, uint8_t actuators) {
+  JsonObject &reported =
+      root.createNestedObject("state").createNestedObject("reported");
+  reported["timestamp"] = "2018-01-01T00:00:00Z";
+  reported.createNestedObject("static")["macAddress"] = "5CCF7F000000";
+  JsonObject &general = reported.createNestedObject("system");
+  general["fwVersion"] = COOL_FW_VERSION;
+  general["wifiSignal"] = -67;
+  JsonObject &sample = reported.createNestedObject("sample");
+  float value = 0.5;
+  for (auto sensor : sensors) {
+    JsonObject &measures =
+        sample.createNestedObject(sensor["key"].as<const char *>());
+    for (auto measure : sensor["measures"].as<JsonArray>()) {
+      measures[measure.as<const char *>()] = value;
+      value += 3.25;
+    }
+  }
+  sample.createNestedObject("battery")["voltage"] = 3.91;
+  if (actuators > 0) {
+    JsonArray &enabled =
+        reported.createNestedObject("actuators").createNestedArray("enabled");
+    for (uint8_t i = 0; i < actuators; i++) {
+      enabled.add(i % 2 == 0);
+    }
+  }
+}
+
+void fillTelemetry(CoolTelemetry &telemetry, JsonArray &sensors,
+                   uint8_t actuators) {
+  telemetry.beginObject();
+  telemetry.beginObject("state");
+  telemetry.beginObject("reported");
+  telemetry.add("timestamp", "2018-01-01T00:00:00Z");
+  telemetry.beginObject("static");
+  telemetry.add("macAddress", "5CCF7F000000");
+  telemetry.endObject();
+  telemetry.beginObject("system");
+  telemetry.add("fwVersion", COOL_FW_VERSION);
+  telemetry.add("wifiSignal", -67);
+  telemetry.endObject();
+  telemetry.beginObject("sample");
+  float value = 0.5;
+  for (auto sensor : sensors) {
+    telemetry.beginObject(sensor["key"].as<const char *>());
+    for (auto measure : sensor["measures"].as<JsonArray>()) {
+      telemetry.add(measure.as<const char *>(), value);
+      value += 3.25;
+    }
+    telemetry.endObject();
+  }
+  telemetry.beginObject("battery");
+  telemetry.add("voltage", 3.91);
+  telemetry.endObject();
+  telemetry.endObject();
+  if (actuators > 0) {
+    telemetry.beginObject("actuators");
+    telemetry.beginArray("enabled");
+    for (uint8_t i = 0; i < actuators; i++) {
+      telemetry.add(NULL, i % 2 == 0);
+    }
+    telemetry.endArray();
+    telemetry.endObject();
+  }
+  telemetry.endObject();
+  telemetry.endObject();
+  telemetry.endObject();
+  while (telemetry.size() % 4 != 0) {
+    telemetry.write((uint8_t)0);
+  }
+}
+
+int compare(const uint8_t *expected, const uint8_t *actual, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    if (expected[i] != actual[i]) {
+      return (i);
+    }
+  }
+  return (-1);
+}
+
+void differential(JsonArray &sensors, uint8_t actuators) {
+  DynamicJsonBuffer buffer;
+  JsonObject &root = buffer.createObject();
+  fillLog(root, sensors, actuators);
+  size_t size = CoolMessagePack::measureJson(root);
+  size_t padded = size + (size % 4 == 0 ? 0 : 4 - size % 4);
+  uint8_t *legacy = (uint8_t *)calloc(padded, 1);
+  uint8_t *written = (uint8_t *)calloc(padded, 1);
+  GString legacyStr = (char *)legacy;
+  PrintAdapter streamer = legacyStr;
+  CoolMessagePack::jsonToMsgpck(streamer, root);
+  GString writtenStr = (char *)written;
+  CoolMessagePack::writeJson(writtenStr, root);
+  CoolTelemetry telemetry;
+  fillTelemetry(telemetry, sensors, actuators);
+
+  int offset = compare(legacy, written, padded);
+  Serial.printf("  writeJson  %s", offset < 0 ? "identical\n" : "differs");
+  if (offset >= 0) {
+    Serial.printf(" at byte %d\n", offset);
+  }
+  if (telemetry.size() != padded) {
+    Serial.printf("  telemetry  differs in size: %u B\n", telemetry.size());
+  } else {
+    offset = compare(legacy, telemetry.data(), padded);
+    Serial.printf("  telemetry  %s", offset < 0 ? "identical\n" : "differs");
+    if (offset >= 0) {
+      Serial.printf(" at byte %d\n", offset);
+    }
+  }
+  CoolTelemetry armored;
+  CoolZ85 z85(armored);
+  z85.write(telemetry.data(), telemetry.size());
+  z85.end();
+  uint8_t *text = (uint8_t *)malloc(armored.size());
+  memcpy(text, armored.data(), armored.size());
+  size_t raw = CoolMessagePack::objectSize(telemetry.data(), telemetry.size());
+  size_t decoded = CoolBacklog::decode(text, armored.size());
+  if (decoded != raw) {
+    Serial.printf("  z85 decode differs in size: %u B\n", decoded);
+  } else {
+    offset = compare(telemetry.data(), text, raw);
+    Serial.printf("  z85 decode %s", offset < 0 ? "identical\n" : "differs");
+    if (offset >= 0) {
+      Serial.printf(" at byte %d\n", offset);
+    }
+  }
+  free(text);
+  uint8_t count = min(8, BACKLOG_BLOCK_SIZE / (int)raw);
+  uint8_t *samples = (uint8_t *)malloc(count * raw);
+  uint8_t *block = (uint8_t *)malloc(count * raw);
+  for (uint8_t i = 0; i < count; i++) {
+    memcpy(samples + i * raw, telemetry.data(), raw);
+  }
+  unsigned long start = micros();
+  size_t packed = CoolBacklog::block(samples, count * raw, count, block,
+                                     count * raw);
+  unsigned long elapsed = micros() - start;
+  size_t expanded = 0;
+  uint8_t *copy = CoolBacklog::expand(block, packed, expanded, count);
+  if (copy == NULL || expanded != count * raw) {
+    Serial.printf("  lzss block fails for %u samples\n", count);
+  } else {
+    offset = compare(samples, copy, expanded);
+    Serial.printf("  lzss block %s, %u B to %u B in %lu us\n",
+                  offset < 0 ? "identical" : "differs", expanded, packed,
+                  elapsed);
+  }
+  free(copy);
+  free(block);
+  free(samples);
+  free(written);
+  free(legacy);
+}
+
+void keyEncoding(JsonArray &sensors, uint8_t actuators) {
+  unsigned long textTime = 0;
+  unsigned long idTime = 0;
+  size_t textSize = 0;
+  size_t idSize = 0;
+
+  for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    unsigned long start = micros();
+    {
+      CoolTelemetry telemetry;
+      fillTelemetry(telemetry, sensors, actuators);
+      textSize = telemetry.size();
+    }
+    textTime += micros() - start;
+    start = micros();
+    {
+      CoolTelemetry telemetry;
+      telemetry.setSchema(&CoolSchema::getInstance());
+      fillTelemetry(telemetry, sensors, actuators);
+      idSize = telemetry.size();
+    }
+    idTime += micros() - start;
+  }
+  Serial.printf("  keys       text %lu us %u B, ids %lu us %u B\n",
+                textTime / BENCHMARK_ITERATIONS, textSize,
+                idTime / BENCHMARK_ITERATIONS, idSize);
+}
+
+void benchmark(const Payload &payload) {
+  Stage stages[STAGE_COUNT] = {{"dom", 0, 0},
+                               {"size", 0, 0},
+                               {"msgpack", 0, 0},
+                               {"z85", 0, 0},
+                               {"write", 0, 0},
+                               {"stream", 0, 0}};
+  DynamicJsonBuffer configBuffer;
+  JsonArray &sensors =
+      configBuffer.parseObject(payload.sensors)["sensors"].as<JsonArray>();
+  uint32_t held = 0;
+  uint32_t size = 0;
+  size_t encoded = 0;
+
+  for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+    uint32_t heap = ESP.getFreeHeap();
+    unsigned long start = micros();
+    DynamicJsonBuffer buffer;
+    JsonObject &root = buffer.createObject();
+    fillLog(root, sensors, payload.actuators);
+    stages[STAGE_DOM].time += micros() - start;
+    stages[STAGE_DOM].heap = heap - ESP.getFreeHeap();
+
+    start = micros();
+    size = CoolMessagePack::sizeJsonToMsgpck(root);
+    stages[STAGE_SIZE].time += micros() - start;
+    stages[STAGE_SIZE].heap = heap - ESP.getFreeHeap();
+
+    uint32_t padded = size + (size % 4 == 0 ? 0 : 4 - size % 4);
+    char *msgpack = (char *)calloc(padded, 1);
+    start = micros();
+    GString str = msgpack;
+    PrintAdapter streamer = str;
+    CoolMessagePack::jsonToMsgpck(streamer, root);
+    stages[STAGE_MSGPACK].time += micros() - start;
+    stages[STAGE_MSGPACK].heap = heap - ESP.getFreeHeap();
+
+    char *output = (char *)malloc((size_t)padded * 1.25 + 3);
+    start = micros();
+    encoded = Z85_encode(msgpack, output, padded);
+    stages[STAGE_Z85].time += micros() - start;
+    stages[STAGE_Z85].heap = heap - ESP.getFreeHeap();
+
+    held = max(held, stages[STAGE_Z85].heap);
+    free(output);
+
+    start = micros();
+    GString written = msgpack;
+    CoolMessagePack::writeJson(written, root);
+    stages[STAGE_WRITE].time += micros() - start;
+    stages[STAGE_WRITE].heap = heap - ESP.getFreeHeap();
+    free(msgpack);
+
+    heap = ESP.getFreeHeap();
+    start = micros();
+    {
+      CoolTelemetry telemetry;
+      fillTelemetry(telemetry, sensors, payload.actuators);
+      CoolMsgpckCounter counter;
+      CoolZ85 z85(counter);
+      z85.write(telemetry.data(), telemetry.size());
+      z85.end();
+      stages[STAGE_STREAM].time += micros() - start;
+      stages[STAGE_STREAM].heap = heap - ESP.getFreeHeap();
+    }
+  }
+  Serial.printf("%-16s msgpack: %u B, z85: %u B\n", payload.name, size,
+                encoded);
+  for (int i = 0; i < STAGE_COUNT; i++) {
+    Serial.printf("  %-8s %8lu us %6u B\n", stages[i].name,
+                  stages[i].time / BENCHMARK_ITERATIONS, stages[i].heap);
+  }
+  Serial.printf("  %-8s %18u B\n", "held", held);
+  differential(sensors, payload.actuators);
+  keyEncoding(sensors, payload.actuators);
+}
+
+void scaling() {
+  Serial.printf("%-8s %8s %10s %10s %8s\n", "sensors", "fields", "size us",
+                "msgpack us", "us/field");
+  for (int count = 0; count <= EXTERNAL_SENSORS_MAX; count++) {
+    DynamicJsonBuffer configBuffer;
+    JsonObject &config = configBuffer.parseObject(payloads[0].sensors);
+    JsonArray &sensors = config["sensors"];
+    for (int i = 0; i < count; i++) {
+      JsonObject &sensor = sensors.createNestedObject();
+      sensor["key"] = String("ADS1115_") + i;
+      JsonArray &measures = sensor.createNestedArray("measures");
+      measures.add("0_voltage");
+      measures.add("1_voltage");
+      measures.add("2_voltage");
+      measures.add("3_voltage");
+    }
+    DynamicJsonBuffer buffer;
+    JsonObject &root = buffer.createObject();
+    fillLog(root, sensors, 0);
+    JsonObject &sample = root["state"]["reported"]["sample"];
+    uint32_t fields = 0;
+    for (auto kv : sample) {
+      fields += kv.value.as<JsonObject>().size();
+    }
+
+    unsigned long sizeTime = 0;
+    unsigned long encodeTime = 0;
+    uint32_t size = CoolMessagePack::sizeJsonToMsgpck(root);
+    char *msgpack = (char *)malloc(size);
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+      unsigned long start = micros();
+      CoolMessagePack::sizeJsonToMsgpck(root);
+      sizeTime += micros() - start;
+      start = micros();
+      GString str = msgpack;
+      PrintAdapter streamer = str;
+      CoolMessagePack::jsonToMsgpck(streamer, root);
+      encodeTime += micros() - start;
+    }
+    free(msgpack);
+    sizeTime /= BENCHMARK_ITERATIONS;
+    encodeTime /= BENCHMARK_ITERATIONS;
+    Serial.printf("%-8d %8u %10lu %10lu %8.2f\n", count, fields, sizeTime,
+                  encodeTime, (float)(sizeTime + encodeTime) / fields);
+  }
+}
+
+bool writeConfigFile() {
+  File file = SPIFFS.open(CONFIG_FILE_PATH, "w");
+  if (!file) {
+    return (false);
+  }
+  size_t written = file.print("{\"actuators\":[");
+  for (int i = 0; written < CONFIG_FILE_SIZE - 256; i++) {
+    written += file.printf(ACTUATOR_FORMAT, i > 0 ? "," : "", i, i % 20,
+                           i % 20 + 10);
+  }
+  file.print("]}");
+  file.close();
+  return (true);
+}
+
+void configParsing() {
+  if (!SPIFFS.begin() || !writeConfigFile()) {
+    Serial.println("config     cannot write " CONFIG_FILE_PATH);
+    return;
+  }
+  uint32_t heap = ESP.getFreeHeap();
+  unsigned long start = micros();
+  {
+    File file = SPIFFS.open(CONFIG_FILE_PATH, "r");
+    Serial.printf("config file %u B\n", file.size());
+    String data = file.readString();
+    file.close();
+    DynamicJsonBuffer buffer;
+    JsonVariant json = buffer.parse(data);
+    uint32_t held = heap - ESP.getFreeHeap();
+    Serial.printf("  %-8s %8lu us %6u B %s\n", "string", micros() - start,
+                  held, json.success() ? "" : "(failed)");
+  }
+  start = micros();
+  {
+    CoolConfig config(CONFIG_FILE_PATH);
+    bool parsed = config.readFileAsJson();
+    Serial.printf("  %-8s %8lu us %6u B %s\n", "stream", micros() - start,
+                  CoolConfig::peakHeap(), parsed ? "" : "(failed)");
+  }
+  SPIFFS.remove(CONFIG_FILE_PATH);
+  SPIFFS.end();
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(100);
+  Serial.printf("\nfree heap: %u B, %d iterations\n", ESP.getFreeHeap(),
+                BENCHMARK_ITERATIONS);
+  DynamicJsonBuffer schemaBuffer;
+  CoolSchema::getInstance().config(
+      schemaBuffer.parseObject("{\"compactKeys\":true}"));
+  CoolSchema::getInstance().begin();
+  for (const Payload &payload : payloads) {
+    benchmark(payload);
+  }
+  scaling();
+  configParsing();
+}
+
+void loop() {}
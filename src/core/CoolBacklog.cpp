@@ -0,0 +1,1073 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include "CoolBacklog.h"
+#include "CoolConfig.h"
+#include "CoolCrc32.h"
+#include "CoolLog.h"
+#include "CoolLzss.h"
+#include "CoolMessagePack.h"
+#include "CoolRtcMemory.h"
+#include "CoolZ85.h"
+#include "z85.h"
+
+static int compareNumbers(const void *a, const void *b) {
+  return (*(const int *)a - *(const int *)b);
+}
+
+CoolBacklog &CoolBacklog::getInstance() {
+  static CoolBacklog instance;
+
+  return instance;
+}
+
+void CoolBacklog::config(JsonObject &json) {
+  String eviction =
+      this->eviction == EVICT_DOWNSAMPLE ? "downsample" : "dropOldest";
+
+  CoolConfig::set<uint32_t>(json, "maxBytes", this->maxBytes);
+  CoolConfig::set<uint32_t>(json, "maxRecords", this->maxRecords);
+  CoolConfig::set<float>(json, "maxFill", this->maxFill);
+  CoolConfig::set<String>(json, "eviction", eviction);
+  CoolConfig::set<bool>(json, "compress", this->compress);
+  CoolConfig::set<bool>(json, "stage", this->staging);
+  this->eviction =
+      eviction == "downsample" ? EVICT_DOWNSAMPLE : EVICT_DROP_OLDEST;
+}
+
+void CoolBacklog::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->maxBytes);
+  snapshot.put(this->maxRecords);
+  snapshot.put(this->maxFill);
+  snapshot.put(this->eviction);
+  snapshot.put(this->compress);
+  snapshot.put(this->staging);
+}
+
+bool CoolBacklog::restore(CoolSnapshot &snapshot) {
+  snapshot.get(this->maxBytes);
+  snapshot.get(this->maxRecords);
+  snapshot.get(this->maxFill);
+  snapshot.get(this->eviction);
+  snapshot.get(this->compress);
+  snapshot.get(this->staging);
+  return (snapshot.isValid());
+}
+
+void CoolBacklog::printConf() {
+  INFO_LOG("Backlog configuration");
+  INFO_VAR("  Max bytes               =", this->maxBytes);
+  INFO_VAR("  Max records             =", this->maxRecords);
+  INFO_VAR("  Max SPIFFS fill         =", this->maxFill);
+  INFO_VAR("  Downsample on eviction  =",
+           this->eviction == EVICT_DOWNSAMPLE);
+  INFO_VAR("  Compressed blocks       =", this->compress);
+  INFO_VAR("  Stage in RTC memory     =", this->staging);
+}
+
+bool CoolBacklog::append(const uint8_t *data, size_t size) {
+  this->load();
+  if (this->staging && CoolMessagePack::objectSize(data, size) == size) {
+    if (this->stageSample(data, size)) {
+      return (true);
+    }
+    if (this->stage.count > 0) {
+      this->flush();
+      if (this->stage.count == 0 && this->stageSample(data, size)) {
+        return (true);
+      }
+    }
+  }
+  this->flush();
+  return (this->store(data, size));
+}
+
+void CoolBacklog::flush() {
+  this->load();
+  if (this->stage.count == 0) {
+    return;
+  }
+  if (!this->store(this->stage.data, this->stage.size)) {
+    return;
+  }
+  INFO_VAR("Moved staged logs to the backlog:", this->stage.count);
+  this->stage.count = 0;
+  this->stage.size = 0;
+  CoolRtcMemory::write(RTC_STAGE_OFFSET, this->stage);
+}
+
+uint8_t CoolBacklog::staged() {
+  // may run before SPIFFS is mounted, so the index is not loaded here
+  if (!this->loaded && !CoolRtcMemory::read(RTC_STAGE_OFFSET, this->stage)) {
+    return (0);
+  }
+  return (this->stage.count);
+}
+
+bool CoolBacklog::stageSample(const uint8_t *data, size_t size) {
+  uint8_t block[BACKLOG_STAGE_SIZE];
+  size_t rawSize = 0;
+  uint8_t count = 0;
+  uint8_t *raw = NULL;
+
+  if (this->stage.count > 0) {
+    raw = CoolBacklog::expand(this->stage.data, this->stage.size, rawSize,
+                              count);
+    if (raw == NULL) {
+      return (false);
+    }
+  }
+  if (rawSize + size > BACKLOG_BLOCK_SIZE || count == 0xff) {
+    free(raw);
+    return (false);
+  }
+  uint8_t *samples = (uint8_t *)realloc(raw, rawSize + size);
+  if (samples == NULL) {
+    free(raw);
+    return (false);
+  }
+  memcpy(samples + rawSize, data, size);
+  // the whole stage is compressed again, so that similar samples fit
+  size_t packed = CoolBacklog::block(samples, rawSize + size, count + 1,
+                                     block, BACKLOG_STAGE_SIZE);
+  free(samples);
+  if (packed == 0) {
+    return (false);
+  }
+  memcpy(this->stage.data, block, packed);
+  this->stage.size = packed;
+  this->stage.count = count + 1;
+  CoolRtcMemory::write(RTC_STAGE_OFFSET, this->stage);
+  DEBUG_VAR("Staged logs in RTC memory:", this->stage.count);
+  return (true);
+}
+
+bool CoolBacklog::store(const uint8_t *data, size_t size) {
+  uint8_t header[BACKLOG_HEADER_SIZE];
+  char name[32];
+
+  if (size > 0xffff) {
+    ERROR_VAR("Log is too large to be saved:", size);
+    return (false);
+  }
+  CoolBacklog::seal(header, BACKLOG_RECORD_PENDING, data, size);
+  this->reclaim(BACKLOG_HEADER_SIZE + size);
+  size_t next = this->index.tailSize + BACKLOG_HEADER_SIZE + size;
+  if (this->index.tailSize > 0 && next > BACKLOG_SEGMENT_SIZE) {
+    this->index.tailSegment++;
+    this->index.tailSize = 0;
+  }
+  CoolBacklog::path(name, this->index.tailSegment);
+  File f = SPIFFS.open(name, "a");
+  if (!f) {
+    ERROR_VAR("Failed to open backlog segment:", name);
+    return (false);
+  }
+  size_t written = f.write(header, BACKLOG_HEADER_SIZE);
+  written += f.write(data, size);
+  f.close();
+  this->index.tailSize += written;
+  if (written != BACKLOG_HEADER_SIZE + size) {
+    ERROR_VAR("Failed to save log in backlog segment:", name);
+    this->save();
+    return (false);
+  }
+  this->index.count++;
+  this->index.bytes += written;
+  this->save();
+  DEBUG_VAR("Saved log in backlog segment:", name);
+  return (true);
+}
+
+bool CoolBacklog::isEmpty() {
+  this->load();
+  return (this->stage.count == 0 &&
+          this->index.headSegment == this->index.tailSegment &&
+          this->index.headOffset >= this->index.tailSize);
+}
+
+CoolBacklogCursor CoolBacklog::head() {
+  this->load();
+  return {this->index.headSegment, this->index.headOffset,
+          this->index.headOffset, 0, 0};
+}
+
+uint32_t CoolBacklog::count() {
+  this->load();
+  return (this->index.count + (this->stage.count > 0 ? 1 : 0));
+}
+
+uint32_t CoolBacklog::bytes() {
+  this->load();
+  return (this->index.bytes + (this->stage.count > 0 ? this->stage.size : 0));
+}
+
+bool CoolBacklog::read(CoolBacklogCursor &cursor, uint8_t *&data,
+                       size_t &size) {
+  return (this->advance(cursor, &data, size));
+}
+
+bool CoolBacklog::commit(const CoolBacklogCursor &cursor) {
+  char name[32];
+
+  this->load();
+  if (cursor.segment == BACKLOG_STAGE_SEGMENT) {
+    CoolBacklogCursor saved = {this->index.tailSegment, this->index.tailSize,
+                               0, 0, 0};
+
+    if (!this->commit(saved)) {
+      return (false);
+    }
+    // samples staged after the block was read are kept for the next time
+    if (cursor.record != this->stage.count ||
+        cursor.offset != this->stage.size) {
+      WARN_LOG("Staged logs changed while being sent, kept them");
+      return (true);
+    }
+    this->stage.count = 0;
+    this->stage.size = 0;
+    CoolRtcMemory::write(RTC_STAGE_OFFSET, this->stage);
+    return (true);
+  }
+  if (cursor.segment == this->index.headSegment &&
+      cursor.offset <= this->index.headOffset) {
+    return (true);
+  }
+  while (this->index.headSegment < cursor.segment &&
+         this->index.headSegment < this->index.tailSegment) {
+    this->remove(this->index.headSegment++);
+    this->index.headOffset = 0;
+  }
+  if (cursor.segment > this->index.tailSegment ||
+      (cursor.segment == this->index.tailSegment &&
+       cursor.offset >= this->index.tailSize)) {
+    this->remove(this->index.tailSegment);
+    this->index.tailSegment++;
+    this->index.tailSize = 0;
+    this->index.headSegment = this->index.tailSegment;
+    this->index.headOffset = 0;
+    this->index.count = 0;
+    this->index.bytes = 0;
+    this->save();
+    return (true);
+  }
+  CoolBacklog::path(name, this->index.headSegment);
+  File f = SPIFFS.open(name, "r+");
+  bool marked = f && f.seek(cursor.record, SeekSet) &&
+                f.write((uint8_t)BACKLOG_RECORD_CONSUMED) == 1;
+  if (f) {
+    f.close();
+  }
+  if (!marked) {
+    ERROR_VAR("Failed to mark sent logs in backlog segment:", name);
+    this->save();
+    return (false);
+  }
+  this->index.headOffset = cursor.offset;
+  this->index.count -= min(cursor.count, this->index.count);
+  this->index.bytes -= min(cursor.bytes, this->index.bytes);
+  this->save();
+  return (true);
+}
+
+size_t CoolBacklog::decode(uint8_t *data, size_t size) {
+  if (data == NULL || size == 0 || data[0] == '{') {
+    return (0);
+  }
+  if (data[0] == '"') {
+    size_t symbols = size < 2 ? 0 : size - 2;
+
+    if (data[size - 1] != '"' || symbols % Z85_SYMBOL_SIZE != 0) {
+      return (0);
+    }
+    // in place: each Z85 group is read before its bytes are overwritten
+    size = Z85_decode((const char *)data + 1, (char *)data, symbols);
+  }
+  return (CoolMessagePack::objectSize(data, size));
+}
+
+size_t CoolBacklog::block(const uint8_t *samples, size_t size, uint8_t count,
+                          uint8_t *output, size_t capacity) {
+  if (size > 0xffff || capacity <= BACKLOG_BLOCK_HEADER_SIZE) {
+    return (0);
+  }
+  size_t packed =
+      CoolLzss::compress(samples, size, output + BACKLOG_BLOCK_HEADER_SIZE,
+                         capacity - BACKLOG_BLOCK_HEADER_SIZE);
+  if (packed == 0) {
+    return (0);
+  }
+  output[0] = BACKLOG_BLOCK_MARKER;
+  output[1] = count;
+  output[2] = size & 0xff;
+  output[3] = size >> 8;
+  return (BACKLOG_BLOCK_HEADER_SIZE + packed);
+}
+
+bool CoolBacklog::isBlock(const uint8_t *data, size_t size) {
+  return (data != NULL && size > BACKLOG_BLOCK_HEADER_SIZE &&
+          data[0] == BACKLOG_BLOCK_MARKER);
+}
+
+uint8_t *CoolBacklog::expand(const uint8_t *data, size_t size,
+                             size_t &rawSize, uint8_t &count) {
+  if (!CoolBacklog::isBlock(data, size)) {
+    return (NULL);
+  }
+  count = data[1];
+  rawSize = data[2] | (data[3] << 8);
+  uint8_t *raw = (uint8_t *)malloc(rawSize + 1);
+  if (raw == NULL) {
+    ERROR_VAR("Not enough memory to expand saved logs of size:", rawSize);
+    return (NULL);
+  }
+  if (CoolLzss::decompress(data + BACKLOG_BLOCK_HEADER_SIZE,
+                           size - BACKLOG_BLOCK_HEADER_SIZE, raw,
+                           rawSize) != rawSize) {
+    ERROR_LOG("Failed to expand compressed saved logs");
+    free(raw);
+    return (NULL);
+  }
+  raw[rawSize] = '\0';
+  return (raw);
+}
+
+void CoolBacklog::load() {
+  if (this->loaded) {
+    return;
+  }
+  this->loaded = true;
+  if (!CoolRtcMemory::read(RTC_STAGE_OFFSET, this->stage) ||
+      this->stage.size > BACKLOG_STAGE_SIZE) {
+    this->stage.count = 0;
+    this->stage.size = 0;
+  }
+  if (ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE &&
+      CoolRtcMemory::read(RTC_BACKLOG_OFFSET, this->index)) {
+    DEBUG_VAR("Backlog index restored, saved logs:", this->index.count);
+    return;
+  }
+  INFO_LOG("Rebuilding backlog index...");
+  this->rebuild();
+}
+
+void CoolBacklog::rebuild() {
+  bool found = false;
+  bool orphan = false;
+  uint32_t temp = 0;
+  uint32_t legacy = 0;
+  char name[32];
+
+  this->index.headSegment = 0;
+  this->index.tailSegment = 0;
+  this->index.tailSize = 0;
+  Dir dir = SPIFFS.openDir(BACKLOG_DIR);
+  while (dir.next()) {
+    String file = dir.fileName();
+    uint32_t segment = file.substring(strlen(BACKLOG_DIR) + 1).toInt();
+    if (file.endsWith(".tmp")) {
+      orphan = true;
+      temp = segment;
+      continue;
+    }
+    if (!file.endsWith(".seg")) {
+      legacy++;
+      continue;
+    }
+    if (!found || segment < this->index.headSegment) {
+      this->index.headSegment = segment;
+    }
+    if (!found || segment > this->index.tailSegment) {
+      this->index.tailSegment = segment;
+      this->index.tailSize = dir.fileSize();
+    }
+    found = true;
+  }
+  // a rewrite only removes the segment once its copy is whole
+  if (orphan) {
+    char copy[32];
+
+    CoolBacklog::path(name, temp);
+    CoolBacklog::path(copy, temp, "tmp");
+    if (SPIFFS.exists(name)) {
+      SPIFFS.remove(copy);
+    } else if (SPIFFS.rename(copy, name)) {
+      WARN_VAR("Restored rewritten backlog segment:", name);
+      if (!found || temp < this->index.headSegment) {
+        this->index.headSegment = temp;
+      }
+      if (!found || temp > this->index.tailSegment) {
+        this->index.tailSegment = temp;
+      }
+      found = true;
+    }
+  }
+  if (found) {
+    this->index.tailSize = this->recover(this->index.tailSegment);
+  }
+  this->index.headOffset = 0;
+  this->index.count = 0;
+  this->index.bytes = 0;
+  for (uint32_t segment = this->index.headSegment;
+       found && segment <= this->index.tailSegment; segment++) {
+    this->scan(segment);
+  }
+  this->index.packSegment = this->index.headSegment;
+  this->save();
+  if (legacy > 0) {
+    this->migrate(legacy);
+  }
+  INFO_VAR("Saved logs in backlog:", this->index.count);
+}
+
+void CoolBacklog::scan(uint32_t segment) {
+  uint8_t header[BACKLOG_HEADER_SIZE];
+  uint32_t offset = 0;
+  char name[32];
+
+  CoolBacklog::path(name, segment);
+  File f = SPIFFS.open(name, "r");
+  if (!f) {
+    return;
+  }
+  while (f.read(header, BACKLOG_HEADER_SIZE) == BACKLOG_HEADER_SIZE) {
+    uint32_t size = BACKLOG_HEADER_SIZE + (header[1] | (header[2] << 8));
+
+    offset += size;
+    this->index.count++;
+    this->index.bytes += size;
+    if (header[0] == BACKLOG_RECORD_CONSUMED) {
+      this->index.headSegment = segment;
+      this->index.headOffset = offset;
+      this->index.count = 0;
+      this->index.bytes = 0;
+    }
+    if (!f.seek(offset, SeekSet)) {
+      break;
+    }
+  }
+  f.close();
+  yield();
+}
+
+uint32_t CoolBacklog::recover(uint32_t segment) {
+  uint8_t header[BACKLOG_HEADER_SIZE];
+  uint8_t chunk[BACKLOG_COPY_SIZE];
+  uint32_t valid = 0;
+  char name[32];
+  char temp[32];
+
+  CoolBacklog::path(name, segment);
+  File in = SPIFFS.open(name, "r");
+  if (!in) {
+    return (0);
+  }
+  uint32_t size = in.size();
+  while (in.read(header, BACKLOG_HEADER_SIZE) == BACKLOG_HEADER_SIZE) {
+    uint32_t length = header[1] | (header[2] << 8);
+
+    if (valid + BACKLOG_HEADER_SIZE + length > size ||
+        !CoolBacklog::check(in, header, length)) {
+      break;
+    }
+    valid += BACKLOG_HEADER_SIZE + length;
+  }
+  in.close();
+  if (valid == size) {
+    return (size);
+  }
+  WARN_VAR("Truncating damaged backlog segment:", name);
+  WARN_VAR("Valid bytes kept:", valid);
+  CoolBacklog::path(temp, segment, "tmp");
+  in = SPIFFS.open(name, "r");
+  File out = SPIFFS.open(temp, "w");
+  bool success = in && out;
+  for (uint32_t left = valid; success && left > 0;) {
+    size_t part = in.read(chunk, min(left, (uint32_t)BACKLOG_COPY_SIZE));
+    success = part > 0 && out.write(chunk, part) == part;
+    left -= part;
+  }
+  if (in) {
+    in.close();
+  }
+  if (out) {
+    out.close();
+  }
+  if (!success || !SPIFFS.remove(name) || !SPIFFS.rename(temp, name)) {
+    ERROR_VAR("Failed to truncate backlog segment:", name);
+    SPIFFS.remove(temp);
+    return (size);
+  }
+  return (valid);
+}
+
+bool CoolBacklog::advance(CoolBacklogCursor &cursor, uint8_t **data,
+                          size_t &size) {
+  uint8_t header[BACKLOG_HEADER_SIZE];
+  char name[32];
+
+  if (data != NULL) {
+    *data = NULL;
+  }
+  size = 0;
+  this->load();
+  while (cursor.segment < this->index.tailSegment ||
+         (cursor.segment == this->index.tailSegment &&
+          cursor.offset < this->index.tailSize)) {
+    CoolBacklog::path(name, cursor.segment);
+    File f = SPIFFS.open(name, "r");
+    if (f && f.seek(cursor.offset, SeekSet) &&
+        f.read(header, BACKLOG_HEADER_SIZE) == BACKLOG_HEADER_SIZE) {
+      size = header[1] | (header[2] << 8);
+      cursor.record = cursor.offset;
+      cursor.offset += BACKLOG_HEADER_SIZE + size;
+      cursor.count++;
+      cursor.bytes += BACKLOG_HEADER_SIZE + size;
+      if (data == NULL) {
+        f.close();
+        return (true);
+      }
+      *data = (uint8_t *)malloc(size + 1);
+      if (*data == NULL) {
+        ERROR_VAR("Not enough memory to read saved log of size:", size);
+      } else if (f.read(*data, size) != size ||
+                 !CoolBacklog::verify(
+                     header, CoolBacklog::checksum(header, *data, size))) {
+        ERROR_VAR("Failed to read saved log from segment:", name);
+        free(*data);
+        *data = NULL;
+      } else {
+        (*data)[size] = '\0';
+      }
+      f.close();
+      return (true);
+    }
+    if (f) {
+      f.close();
+    }
+    cursor.segment++;
+    cursor.offset = 0;
+  }
+  // the stage reads as one last block, straight from RTC memory: record
+  // holds the staged count and offset the block size, to commit it
+  if (cursor.segment == BACKLOG_STAGE_SEGMENT || this->stage.count == 0) {
+    return (false);
+  }
+  cursor.segment = BACKLOG_STAGE_SEGMENT;
+  cursor.record = this->stage.count;
+  cursor.offset = this->stage.size;
+  cursor.count++;
+  cursor.bytes += this->stage.size;
+  size = this->stage.size;
+  if (data == NULL) {
+    return (true);
+  }
+  *data = (uint8_t *)malloc(size + 1);
+  if (*data == NULL) {
+    ERROR_VAR("Not enough memory to read staged logs of size:", size);
+    return (true);
+  }
+  memcpy(*data, this->stage.data, size);
+  (*data)[size] = '\0';
+  return (true);
+}
+
+void CoolBacklog::compact() {
+  uint32_t count;
+  uint32_t bytes;
+
+  this->load();
+  // sent logs are skipped by the head offset, the quota check in reclaim()
+  // drops them when the SPIFFS fills up, here only once they are most of
+  // a segment
+  if (this->index.headOffset >= BACKLOG_COMPACT_OFFSET) {
+    DEBUG_VAR("Compacting backlog segment:", this->index.headSegment);
+    this->rewrite(this->index.headSegment, false, count, bytes);
+  }
+  this->reclaim(0);
+  if (!this->compress) {
+    return;
+  }
+  for (uint32_t segment =
+           max(this->index.packSegment, this->index.headSegment);
+       segment < this->index.tailSegment; segment++) {
+    if (this->pack(segment)) {
+      DEBUG_VAR("Compressed backlog segment:", segment);
+    }
+  }
+  this->index.packSegment = this->index.tailSegment;
+  this->save();
+}
+
+void CoolBacklog::reclaim(size_t incoming) {
+  uint32_t records = 0;
+  uint32_t bytes = 0;
+  bool full = false;
+  FSInfo info;
+
+  if (this->maxRecords > 0 &&
+      this->index.count + (incoming > 0 ? 1 : 0) > this->maxRecords) {
+    records = this->index.count + (incoming > 0 ? 1 : 0) - this->maxRecords;
+  }
+  if (this->maxBytes > 0 && this->index.bytes + incoming > this->maxBytes) {
+    bytes = this->index.bytes + incoming - this->maxBytes;
+  }
+  if (this->maxFill > 0 && SPIFFS.info(info)) {
+    size_t limit = info.totalBytes * this->maxFill;
+    if (info.usedBytes + incoming > limit) {
+      bytes = max(bytes, (uint32_t)(info.usedBytes + incoming - limit));
+      full = true;
+    }
+  }
+  if ((records == 0 && bytes == 0) || this->index.count == 0) {
+    return;
+  }
+  WARN_VAR("Backlog is over quota, saved logs:", this->index.count);
+  if (this->eviction == EVICT_DOWNSAMPLE) {
+    for (uint32_t segment = this->index.headSegment;
+         segment < this->index.tailSegment && (records > 0 || bytes > 0);
+         segment++) {
+      uint32_t count;
+      uint32_t freed;
+
+      if (this->rewrite(segment, true, count, freed)) {
+        WARN_VAR("Downsampled saved logs, dropped:", count);
+        records -= min(records, count);
+        bytes -= min(bytes, freed);
+      }
+    }
+  }
+  if (records > 0 || bytes > 0) {
+    this->drop(records, bytes);
+  }
+  if (full && this->index.headOffset > 0) {
+    uint32_t count;
+    uint32_t freed;
+
+    this->rewrite(this->index.headSegment, false, count, freed);
+  }
+}
+
+void CoolBacklog::drop(uint32_t records, uint32_t bytes) {
+  CoolBacklogCursor cursor = {this->index.headSegment, this->index.headOffset,
+                              this->index.headOffset, 0, 0};
+  CoolBacklogCursor next = cursor;
+  size_t size;
+
+  // staged logs are the newest ones, never drop them for the SPIFFS quota
+  while ((cursor.count < records || cursor.bytes < bytes) &&
+         this->advance(next, NULL, size) &&
+         next.segment != BACKLOG_STAGE_SEGMENT) {
+    cursor = next;
+  }
+  WARN_VAR("Dropped oldest saved logs:", cursor.count);
+  this->commit(cursor);
+}
+
+bool CoolBacklog::rewrite(uint32_t segment, bool thin, uint32_t &count,
+                          uint32_t &bytes) {
+  uint8_t header[BACKLOG_HEADER_SIZE];
+  uint8_t chunk[BACKLOG_COPY_SIZE];
+  uint32_t offset =
+      segment == this->index.headSegment ? this->index.headOffset : 0;
+  uint32_t position = 0;
+  uint32_t records = 0;
+  uint32_t total = 0;
+  uint32_t keptRecords = 0;
+  uint32_t keptBytes = 0;
+  bool success = true;
+  char name[32];
+  char temp[32];
+
+  count = 0;
+  bytes = 0;
+  CoolBacklog::path(name, segment);
+  CoolBacklog::path(temp, segment, "tmp");
+  File in = SPIFFS.open(name, "r");
+  if (!in || !in.seek(offset, SeekSet)) {
+    return (false);
+  }
+  File out = SPIFFS.open(temp, "w");
+  if (!out) {
+    in.close();
+    return (false);
+  }
+  while (success &&
+         in.read(header, BACKLOG_HEADER_SIZE) == BACKLOG_HEADER_SIZE) {
+    uint32_t length = header[1] | (header[2] << 8);
+    uint32_t copied = min(length, (uint32_t)BACKLOG_COPY_SIZE);
+    uint32_t start = in.position();
+
+    if (thin && header[0] == BACKLOG_RECORD_THINNED) {
+      success = false;
+      break;
+    }
+    records++;
+    // a damaged record would be sealed again with a valid CRC, drop it
+    if (!CoolBacklog::check(in, header, length)) {
+      WARN_VAR("Dropped damaged saved log from segment:", name);
+      total += BACKLOG_HEADER_SIZE + in.position() - start;
+      continue;
+    }
+    total += BACKLOG_HEADER_SIZE + length;
+    if (!in.seek(start, SeekSet) || in.read(chunk, copied) != copied) {
+      success = false;
+      break;
+    }
+    if (thin) {
+      header[0] = BACKLOG_RECORD_THINNED;
+    }
+    // blocks hold many samples, thin them one sample at a time
+    if (thin && CoolBacklog::isBlock(chunk, length)) {
+      uint8_t *data = (uint8_t *)malloc(length);
+
+      success = data != NULL;
+      if (success) {
+        memcpy(data, chunk, copied);
+        success =
+            in.read(data + copied, length - copied) == length - copied &&
+            this->thinBlock(out, header[0], data, length, position,
+                            keptRecords, keptBytes);
+      }
+      free(data);
+      yield();
+      continue;
+    }
+    // JSON text logs are update answers, never downsample them
+    if (thin && length > 0 && chunk[0] != '{' && position++ % 2 == 1) {
+      success = in.seek(length - copied, SeekCur);
+      continue;
+    }
+    success = out.write(header, BACKLOG_HEADER_SIZE) == BACKLOG_HEADER_SIZE &&
+              out.write(chunk, copied) == copied;
+    for (uint32_t left = length - copied; success && left > 0;) {
+      size_t part = in.read(chunk, min(left, (uint32_t)BACKLOG_COPY_SIZE));
+      success = part > 0 && out.write(chunk, part) == part;
+      left -= part;
+    }
+    keptRecords++;
+    keptBytes += BACKLOG_HEADER_SIZE + length;
+    yield();
+  }
+  in.close();
+  out.close();
+  if (!success || !SPIFFS.remove(name) || !SPIFFS.rename(temp, name)) {
+    SPIFFS.remove(temp);
+    return (false);
+  }
+  if (segment == this->index.headSegment) {
+    this->index.headOffset = 0;
+  }
+  if (segment == this->index.tailSegment) {
+    this->index.tailSize = keptBytes;
+  }
+  count = records - min(records, keptRecords);
+  bytes = total - min(total, keptBytes);
+  this->index.count =
+      this->index.count - min(records, this->index.count) + keptRecords;
+  this->index.bytes =
+      this->index.bytes - min(total, this->index.bytes) + keptBytes;
+  this->save();
+  return (true);
+}
+
+bool CoolBacklog::thinBlock(File &out, uint8_t flag, const uint8_t *data,
+                            size_t size, uint32_t &position,
+                            uint32_t &records, uint32_t &bytes) {
+  size_t rawSize = 0;
+  size_t used = 0;
+  uint8_t count = 0;
+  uint8_t kept = 0;
+  uint8_t *raw = CoolBacklog::expand(data, size, rawSize, count);
+
+  if (raw == NULL) {
+    return (false);
+  }
+  for (size_t offset = 0; offset < rawSize;) {
+    size_t object =
+        CoolMessagePack::objectSize(raw + offset, rawSize - offset);
+    if (object == 0) {
+      break;
+    }
+    if (position++ % 2 == 0) {
+      memmove(raw + used, raw + offset, object);
+      used += object;
+      kept++;
+    }
+    offset += object;
+  }
+  bool success = this->flush(out, flag, raw, used, kept, records, bytes);
+  free(raw);
+  return (success);
+}
+
+bool CoolBacklog::pack(uint32_t segment) {
+  uint8_t header[BACKLOG_HEADER_SIZE];
+  uint32_t offset =
+      segment == this->index.headSegment ? this->index.headOffset : 0;
+  uint32_t records = 0;
+  uint32_t bytes = 0;
+  uint32_t packedRecords = 0;
+  uint32_t packedBytes = 0;
+  uint8_t flag = BACKLOG_RECORD_PENDING;
+  uint8_t samples = 0;
+  size_t used = 0;
+  bool success = true;
+  char name[32];
+  char temp[32];
+
+  CoolBacklog::path(name, segment);
+  CoolBacklog::path(temp, segment, "tmp");
+  File in = SPIFFS.open(name, "r");
+  if (!in || !in.seek(offset, SeekSet)) {
+    return (false);
+  }
+  uint8_t *block = (uint8_t *)malloc(BACKLOG_BLOCK_SIZE);
+  File out = SPIFFS.open(temp, "w");
+  if (block == NULL || !out) {
+    ERROR_LOG("Failed to compress backlog segment");
+    free(block);
+    in.close();
+    return (false);
+  }
+  while (success &&
+         in.read(header, BACKLOG_HEADER_SIZE) == BACKLOG_HEADER_SIZE) {
+    uint32_t length = header[1] | (header[2] << 8);
+    uint8_t *data = (uint8_t *)malloc(length + 1);
+
+    if (data == NULL) {
+      success = false;
+      break;
+    }
+    size_t got = in.read(data, length);
+    records++;
+    bytes += BACKLOG_HEADER_SIZE + got;
+    // a damaged record would be sealed again with a valid CRC, drop it
+    if (got != length ||
+        !CoolBacklog::verify(header,
+                             CoolBacklog::checksum(header, data, length))) {
+      WARN_VAR("Dropped damaged saved log from segment:", name);
+      free(data);
+      continue;
+    }
+    bool packed = CoolBacklog::isBlock(data, length);
+    size_t object = packed ? 0 : CoolBacklog::decode(data, length);
+    if (object == 0 || used + object > BACKLOG_BLOCK_SIZE ||
+        samples == 0xff) {
+      success = this->flush(out, flag, block, used, samples, packedRecords,
+                            packedBytes);
+      flag = BACKLOG_RECORD_PENDING;
+      samples = 0;
+      used = 0;
+    }
+    if (object > 0 && object <= BACKLOG_BLOCK_SIZE) {
+      memcpy(block + used, data, object);
+      used += object;
+      samples++;
+      if (header[0] == BACKLOG_RECORD_THINNED) {
+        flag = BACKLOG_RECORD_THINNED;
+      }
+    } else if (success) {
+      size_t kept = object > 0 ? object : length;
+
+      success = CoolBacklog::write(out, header[0], data, kept);
+      packedRecords++;
+      packedBytes += BACKLOG_HEADER_SIZE + kept;
+    }
+    free(data);
+    yield();
+  }
+  if (success) {
+    success = this->flush(out, flag, block, used, samples, packedRecords,
+                          packedBytes);
+  }
+  free(block);
+  in.close();
+  out.close();
+  // nothing was merged, the segment is already compressed
+  if (packedRecords >= records) {
+    success = false;
+  }
+  if (!success || !SPIFFS.remove(name) || !SPIFFS.rename(temp, name)) {
+    SPIFFS.remove(temp);
+    return (false);
+  }
+  if (segment == this->index.headSegment) {
+    this->index.headOffset = 0;
+  }
+  this->index.count = this->index.count - min(records, this->index.count) +
+                      packedRecords;
+  this->index.bytes =
+      this->index.bytes - min(bytes, this->index.bytes) + packedBytes;
+  this->save();
+  return (true);
+}
+
+bool CoolBacklog::flush(File &out, uint8_t flag, const uint8_t *samples,
+                        size_t size, uint8_t count, uint32_t &records,
+                        uint32_t &bytes) {
+  if (count > 1) {
+    uint8_t *payload = (uint8_t *)malloc(size);
+    size_t packed = payload == NULL
+                        ? 0
+                        : CoolBacklog::block(samples, size, count, payload,
+                                             size);
+    if (packed > 0) {
+      bool written = CoolBacklog::write(out, flag, payload, packed);
+      free(payload);
+      records++;
+      bytes += BACKLOG_HEADER_SIZE + packed;
+      return (written);
+    }
+    free(payload);
+  }
+  // too few or too different samples: keep them as plain records
+  for (size_t offset = 0; offset < size;) {
+    size_t object =
+        CoolMessagePack::objectSize(samples + offset, size - offset);
+    if (object == 0 ||
+        !CoolBacklog::write(out, flag, samples + offset, object)) {
+      return (false);
+    }
+    offset += object;
+    records++;
+    bytes += BACKLOG_HEADER_SIZE + object;
+  }
+  return (true);
+}
+
+void CoolBacklog::migrate(uint32_t count) {
+  int *numbers = (int *)malloc(count * sizeof(int));
+  uint32_t found = 0;
+  char name[32];
+
+  if (numbers == NULL) {
+    ERROR_LOG("Not enough memory to migrate saved logs");
+    return;
+  }
+  Dir dir = SPIFFS.openDir(BACKLOG_DIR);
+  while (dir.next() && found < count) {
+    String file = dir.fileName();
+    if (file.endsWith(".json")) {
+      numbers[found++] = file.substring(strlen(BACKLOG_DIR) + 1).toInt();
+    }
+  }
+  qsort(numbers, found, sizeof(int), compareNumbers);
+  for (uint32_t i = 0; i < found; i++) {
+    snprintf(name, 32, BACKLOG_DIR "/%d.json", numbers[i]);
+    File f = SPIFFS.open(name, "r");
+    if (!f) {
+      continue;
+    }
+    size_t size = f.size();
+    uint8_t *data = (uint8_t *)malloc(size + 1);
+    bool saved = data != NULL && f.read(data, size) == size &&
+                 this->append(data, size);
+    free(data);
+    f.close();
+    if (!saved) {
+      ERROR_VAR("Failed to migrate saved log:", name);
+      break;
+    }
+    SPIFFS.remove(name);
+    yield();
+  }
+  INFO_VAR("Saved logs moved to the backlog:", found);
+  free(numbers);
+}
+
+void CoolBacklog::remove(uint32_t segment) {
+  char name[32];
+
+  CoolBacklog::path(name, segment);
+  if (SPIFFS.remove(name)) {
+    DEBUG_VAR("Deleted backlog segment:", name);
+  } else {
+    ERROR_VAR("Failed to delete backlog segment:", name);
+  }
+}
+
+void CoolBacklog::save() {
+  CoolRtcMemory::write(RTC_BACKLOG_OFFSET, this->index);
+}
+
+void CoolBacklog::seal(uint8_t *header, uint8_t flag, const uint8_t *data,
+                       size_t size) {
+  header[0] = flag;
+  header[1] = size & 0xff;
+  header[2] = size >> 8;
+  uint32_t crc = CoolBacklog::checksum(header, data, size);
+  for (uint8_t i = 0; i < 4; i++) {
+    header[3 + i] = crc >> (8 * i);
+  }
+}
+
+uint32_t CoolBacklog::checksum(const uint8_t *header, const uint8_t *data,
+                               size_t size) {
+  // the flag is left out, it changes when the record is sent
+  return (CoolCrc32::update(CoolCrc32::update(0, header + 1, 2), data, size));
+}
+
+bool CoolBacklog::check(File &in, const uint8_t *header, uint32_t length) {
+  uint8_t chunk[BACKLOG_COPY_SIZE];
+  uint32_t crc = CoolCrc32::update(0, header + 1, 2);
+
+  while (length > 0) {
+    size_t part = in.read(chunk, min(length, (uint32_t)BACKLOG_COPY_SIZE));
+    if (part == 0) {
+      return (false);
+    }
+    crc = CoolCrc32::update(crc, chunk, part);
+    length -= part;
+  }
+  return (CoolBacklog::verify(header, crc));
+}
+
+bool CoolBacklog::verify(const uint8_t *header, uint32_t crc) {
+  if (header[0] != BACKLOG_RECORD_PENDING &&
+      header[0] != BACKLOG_RECORD_CONSUMED &&
+      header[0] != BACKLOG_RECORD_THINNED) {
+    return (false);
+  }
+  for (uint8_t i = 0; i < 4; i++) {
+    if (header[3 + i] != (uint8_t)(crc >> (8 * i))) {
+      return (false);
+    }
+  }
+  return (true);
+}
+
+bool CoolBacklog::write(File &out, uint8_t flag, const uint8_t *data,
+                        size_t size) {
+  uint8_t header[BACKLOG_HEADER_SIZE];
+
+  CoolBacklog::seal(header, flag, data, size);
+  return (out.write(header, BACKLOG_HEADER_SIZE) == BACKLOG_HEADER_SIZE &&
+          out.write(data, size) == size);
+}
+
+void CoolBacklog::path(char *buffer, uint32_t segment,
+                       const char *extension) {
+  snprintf(buffer, 32, BACKLOG_DIR "/%lu.%s", (unsigned long)segment,
+           extension);
+}
@@ -0,0 +1,145 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLBACKLOG_H
+#define COOLBACKLOG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <FS.h>
+
+#include "CoolSnapshot.h"
+
+#define BACKLOG_DIR "/log"
+#define BACKLOG_SEGMENT_SIZE 4096
+#define BACKLOG_COMPACT_OFFSET (BACKLOG_SEGMENT_SIZE * 3 / 4)
+#define BACKLOG_HEADER_SIZE 7
+#define BACKLOG_RECORD_PENDING 0x52
+#define BACKLOG_RECORD_CONSUMED 0x43
+#define BACKLOG_RECORD_THINNED 0x54
+#define BACKLOG_COPY_SIZE 64
+#define BACKLOG_DEFAULT_MAX_FILL 0.75
+#define BACKLOG_BLOCK_MARKER 0xc1
+#define BACKLOG_BLOCK_HEADER_SIZE 4
+#define BACKLOG_BLOCK_SIZE 1536
+#define BACKLOG_STAGE_SIZE 224
+#define BACKLOG_STAGE_SEGMENT 0xffffffff
+
+enum BacklogEviction { EVICT_DROP_OLDEST = 0, EVICT_DOWNSAMPLE };
+
+struct CoolBacklogCursor {
+  uint32_t segment;
+  uint32_t offset;
+  uint32_t record;
+  uint32_t count;
+  uint32_t bytes;
+};
+
+class CoolBacklog {
+
+public:
+  static CoolBacklog &getInstance();
+  void config(JsonObject &json);
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
+  void printConf();
+  bool append(const uint8_t *data, size_t size);
+  void flush();
+  uint8_t staged();
+  bool isEmpty();
+  CoolBacklogCursor head();
+  bool read(CoolBacklogCursor &cursor, uint8_t *&data, size_t &size);
+  bool commit(const CoolBacklogCursor &cursor);
+  uint32_t count();
+  uint32_t bytes();
+  void compact();
+
+  static size_t decode(uint8_t *data, size_t size);
+  static size_t block(const uint8_t *samples, size_t size, uint8_t count,
+                      uint8_t *output, size_t capacity);
+  static bool isBlock(const uint8_t *data, size_t size);
+  static uint8_t *expand(const uint8_t *data, size_t size, size_t &rawSize,
+                         uint8_t &count);
+
+  CoolBacklog(CoolBacklog const &) = delete;
+  void operator=(CoolBacklog const &) = delete;
+
+private:
+  CoolBacklog() {}
+  void load();
+  bool store(const uint8_t *data, size_t size);
+  bool stageSample(const uint8_t *data, size_t size);
+  void rebuild();
+  void scan(uint32_t segment);
+  uint32_t recover(uint32_t segment);
+  bool advance(CoolBacklogCursor &cursor, uint8_t **data, size_t &size);
+  void reclaim(size_t incoming);
+  void drop(uint32_t records, uint32_t bytes);
+  bool rewrite(uint32_t segment, bool thin, uint32_t &count,
+               uint32_t &bytes);
+  bool thinBlock(File &out, uint8_t flag, const uint8_t *data, size_t size,
+                 uint32_t &position, uint32_t &records, uint32_t &bytes);
+  bool pack(uint32_t segment);
+  bool flush(File &out, uint8_t flag, const uint8_t *samples, size_t size,
+             uint8_t count, uint32_t &records, uint32_t &bytes);
+  void migrate(uint32_t count);
+  void remove(uint32_t segment);
+  void save();
+  static void seal(uint8_t *header, uint8_t flag, const uint8_t *data,
+                   size_t size);
+  static uint32_t checksum(const uint8_t *header, const uint8_t *data,
+                           size_t size);
+  static bool check(File &in, const uint8_t *header, uint32_t length);
+  static bool verify(const uint8_t *header, uint32_t crc);
+  static bool write(File &out, uint8_t flag, const uint8_t *data,
+                    size_t size);
+  static void path(char *buffer, uint32_t segment,
+                   const char *extension = "seg");
+
+  bool loaded = false;
+  uint32_t maxBytes = 0;
+  uint32_t maxRecords = 0;
+  float maxFill = BACKLOG_DEFAULT_MAX_FILL;
+  BacklogEviction eviction = EVICT_DROP_OLDEST;
+  bool compress = false;
+  bool staging = false;
+  struct {
+    uint32_t crc;
+    uint32_t headSegment;
+    uint32_t headOffset;
+    uint32_t tailSegment;
+    uint32_t tailSize;
+    uint32_t count;
+    uint32_t bytes;
+    uint32_t packSegment;
+  } index = {};
+  struct {
+    uint32_t crc;
+    uint16_t size;
+    uint8_t count;
+    uint8_t reserved;
+    uint8_t data[BACKLOG_STAGE_SIZE];
+  } stage = {};
+};
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include <Arduino.h>
+
+#include "CoolBatchClient.h"
+#include "CoolLog.h"
+
+bool CoolBatchClient::hold(size_t size) {
+  this->drop();
+  this->batch = (uint8_t *)malloc(size);
+  if (!this->batch) {
+    ERROR_VAR("Failed to allocate MQTT batch of size:", size);
+    return (false);
+  }
+  this->capacity = size;
+  return (true);
+}
+
+bool CoolBatchClient::release() {
+  if (!this->batch) {
+    return (false);
+  }
+  bool sent = !this->overflow &&
+              this->client.write(this->batch, this->length) == this->length;
+  if (this->overflow) {
+    ERROR_VAR("MQTT batch overflow, capacity:", this->capacity);
+  }
+  this->drop();
+  return (sent);
+}
+
+int CoolBatchClient::connect(IPAddress ip, uint16_t port) {
+  this->drop();
+  return (this->client.connect(ip, port));
+}
+
+int CoolBatchClient::connect(const char *host, uint16_t port) {
+  this->drop();
+  return (this->client.connect(host, port));
+}
+
+size_t CoolBatchClient::write(uint8_t c) { return (this->write(&c, 1)); }
+
+size_t CoolBatchClient::write(const uint8_t *data, size_t size) {
+  if (!this->batch) {
+    return (this->client.write(data, size));
+  }
+  if (this->overflow || this->length + size > this->capacity) {
+    this->overflow = true;
+    return (0);
+  }
+  memcpy(this->batch + this->length, data, size);
+  this->length += size;
+  return (size);
+}
+
+void CoolBatchClient::stop() {
+  this->drop();
+  this->client.stop();
+}
+
+void CoolBatchClient::drop() {
+  free(this->batch);
+  this->batch = NULL;
+  this->capacity = 0;
+  this->length = 0;
+  this->overflow = false;
+}
@@ -0,0 +1,69 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLBATCHCLIENT_H
+#define COOLBATCHCLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Forwards to another client. Between hold() and release() writes are
+// gathered and sent with a single write(), which axTLS turns into a single
+// TLS record however many small writes PubSubClient and CoolZ85 make.
+class CoolBatchClient : public Client {
+
+public:
+  CoolBatchClient(Client &client) : client(client) {}
+  ~CoolBatchClient() { this->drop(); }
+  bool hold(size_t size);
+  bool release();
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *data, size_t size) override;
+  int available() override { return (this->client.available()); }
+  int read() override { return (this->client.read()); }
+  int read(uint8_t *data, size_t size) override {
+    return (this->client.read(data, size));
+  }
+  int peek() override { return (this->client.peek()); }
+  void flush() override { this->client.flush(); }
+  void stop() override;
+  uint8_t connected() override { return (this->client.connected()); }
+  operator bool() override { return ((bool)this->client); }
+
+  CoolBatchClient(CoolBatchClient const &) = delete;
+  void operator=(CoolBatchClient const &) = delete;
+
+private:
+  void drop();
+
+  Client &client;
+  uint8_t *batch = NULL;
+  size_t capacity = 0;
+  size_t length = 0;
+  bool overflow = false;
+};
+
+#endif
@@ -28,30 +28,79 @@
 
 #include "CoolBoard.h"
 #include "CoolConfig.h"
+#include "CoolCrc32.h"
 #include "CoolLog.h"
+#include "CoolProfiler.h"
 #include "libb64/cdecode.h"
 
 void CoolBoard::begin() {
+  CoolProfiler &profiler = CoolProfiler::getInstance();
+  uint32_t hash = 0;
+
+  profiler.start(PHASE_BOOT);
+  // RTC memory is too small for the settings, so a warm boot still mounts
+  // SPIFFS to load the snapshot; it stays mounted for loop(), which needs
+  // it for the saved logs anyway
+  bool warm = ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE &&
+              CoolSnapshot::recall(hash);
   this->powerCheck();
   WiFi.mode(WIFI_STA);
   if (!SPIFFS.begin()) {
     this->spiffsProblem();
   }
+  if (!warm) {
+    hash = this->coldPrepare();
+  }
   this->sleep();
-  if (!this->coolBoardLed.config()) {
+  bool restored = this->restoreConfig(hash);
+  if (warm && !restored) {
+    WARN_LOG("Snapshot of the warm boot not found, doing a full boot");
+    warm = false;
+    restored = this->restoreConfig(this->coldPrepare());
+  }
+  if (warm) {
+    this->warmBegin();
+  } else {
+    this->coldBegin(restored);
+  }
+  this->mqttsConfig(warm);
+  if (!warm) {
+    delay(100);
+    SPIFFS.end();
+  }
+  profiler.stop(PHASE_BOOT);
+}
+
+uint32_t CoolBoard::coldPrepare() {
+  CoolSnapshot::forget();
+  CoolFileSystem::recover();
+  return (CoolSnapshot::hash());
+}
+
+void CoolBoard::coldBegin(bool restored) {
+  // keep one shared file parsed at a time, freed after its last reader
+  CoolConfig::share("/general.json");
+  if (!restored && !this->coolBoardLed.config()) {
     this->spiffsProblem();
   }
   this->coolBoardLed.begin();
   delay(10);
   this->coolBoardLed.write(YELLOW);
-  if (!this->config()) {
+  if (restored) {
+    this->tryFirmwareUpdate();
+  } else if (!this->config()) {
+    this->spiffsProblem();
+  }
+  CoolConfig::release("/general.json");
+  if (!restored && !this->jetPack.config()) {
     this->spiffsProblem();
   }
+  CoolConfig::share("/sensors.json");
   pinMode(ENABLE_I2C_PIN, OUTPUT);
   pinMode(BOOTSTRAP_PIN, INPUT);
   digitalWrite(ENABLE_I2C_PIN, HIGH);
   delay(100);
-  if (!this->coolBoardSensors.config()) {
+  if (!restored && !this->coolBoardSensors.config()) {
     this->spiffsProblem();
   }
   this->coolBoardSensors.begin();
@@ -59,59 +108,99 @@ void CoolBoard::begin() {
   this->printConf();
   this->coolBoardLed.printConf();
   this->coolBoardSensors.printConf();
-  if (!this->jetPack.config()) {
-    this->spiffsProblem();
-  }
   this->jetPack.begin();
   this->jetPack.printConf();
   delay(100);
-  if (!this->irene3000.config()) {
+  if (!restored && !this->irene3000.config()) {
     this->spiffsProblem();
   }
   this->irene3000.begin();
-  this->irene3000.calibrate(this->coolBoardLed);
+  bool calibrated = this->irene3000.calibrate(this->coolBoardLed);
   this->irene3000.printConf();
   delay(100);
-  if (!this->externalSensors->config()) {
+  if (!restored && !this->externalSensors->config()) {
     this->spiffsProblem();
   }
   this->externalSensors->begin();
   delay(100);
-  this->mqttsConfig();
+  if (!restored && !CoolSchema::getInstance().begin()) {
+    this->spiffsProblem();
+  }
+  CoolConfig::release("/sensors.json");
+  CoolSchema::getInstance().printConf();
+  if (!restored && !calibrated) {
+    this->saveConfig();
+  }
+}
+
+void CoolBoard::warmBegin() {
+  INFO_LOG("Warm boot, skipping configuration and calibration");
+  this->coolBoardLed.begin();
+  pinMode(ENABLE_I2C_PIN, OUTPUT);
+  pinMode(BOOTSTRAP_PIN, INPUT);
+  digitalWrite(ENABLE_I2C_PIN, HIGH);
   delay(100);
-  SPIFFS.end();
+  this->coolBoardSensors.begin();
+  this->jetPack.begin();
+  this->irene3000.begin();
+  this->externalSensors->begin();
 }
 
 void CoolBoard::loop() {
+  CoolProfiler &profiler = CoolProfiler::getInstance();
+
+  profiler.start(PHASE_POWER_CHECK);
   this->powerCheck();
+  profiler.stop(PHASE_POWER_CHECK);
+  profiler.start(PHASE_SPIFFS_MOUNT);
   if (!SPIFFS.begin()) {
     this->spiffsProblem();
   }
+  profiler.stop(PHASE_SPIFFS_MOUNT);
   if (!this->isConnected()) {
     this->coolPubSubClient->disconnect();
     INFO_LOG("Connecting...");
+    profiler.start(PHASE_CONNECT);
     this->connect();
+    profiler.stop(PHASE_CONNECT);
   }
   INFO_LOG("Synchronizing RTC...");
+  profiler.start(PHASE_TIME_SYNC);
   bool rtcSynced = CoolTime::getInstance().sync();
+  profiler.stop(PHASE_TIME_SYNC);
   if (!rtcSynced) {
     this->clockProblem();
   } else {
+    CoolTelemetry telemetry;
+
     INFO_LOG("Collecting board and sensor data...");
-    char *logLoop = this->createLog();
+    profiler.start(PHASE_CREATE_LOG);
+    this->createLog(telemetry);
+    profiler.stop(PHASE_CREATE_LOG);
     delay(50);
     if (this->shouldLog()) {
       INFO_LOG("Sending log over MQTT...");
-      this->mqttLog(logLoop, 1);
+      profiler.start(PHASE_MQTT_LOG);
+      this->sendSchema();
+      if (this->batchActive) {
+        this->mqttBatch(telemetry.data(), telemetry.size());
+      } else {
+        this->mqttLog(telemetry.data(), telemetry.size());
+      }
+      profiler.stop(PHASE_MQTT_LOG);
       this->previousLogTime = millis();
     }
-    free(logLoop);
-    if (CoolFileSystem::hasSavedLogs()) {
+    // staged logs stay in RTC memory until they can be sent
+    if (this->isConnected() && !CoolBacklog::getInstance().isEmpty()) {
       INFO_LOG("Sending saved messages...");
+      profiler.start(PHASE_SEND_SAVED);
       this->sendSavedMessages();
+      profiler.stop(PHASE_SEND_SAVED);
     }
     INFO_LOG("Listening to update messages...");
+    profiler.start(PHASE_MQTT_LISTEN);
     this->mqttListen();
+    profiler.stop(PHASE_MQTT_LISTEN);
     if (this->updateAnswer != "") {
       if (this->update(this->updateAnswer)) {
         if (this->connection) {
@@ -120,43 +209,44 @@ void CoolBoard::loop() {
         } else {
           mqttLog(this->updateAnswer.c_str());
           this->updateAnswer = "";
+          this->settleLive();
           SPIFFS.end();
           ESP.restart();
         }
       }
     }
   }
+  // live logs without an acknowledgement yet go to the backlog
+  this->settleLive();
+  CoolBacklog::getInstance().compact();
   SPIFFS.end();
   if (this->sleepActive && (!this->shouldLog() || !rtcSynced)) {
     this->sleep();
   }
+  profiler.commit();
 }
 
-char *CoolBoard::createLog() {
-  DynamicJsonBuffer buffer;
-  JsonObject &root = buffer.createObject();
-  JsonObject &state = root.createNestedObject("state");
-  JsonObject &reported = state.createNestedObject("reported");
-  this->readBoardData(reported);
-  this->readSensors(reported);
-  this->handleActuators(reported);
-  uint32_t size = CoolMessagePack::sizeJsonToMsgpck(root);
-  size = size + (size % 4 == 0 ? 0 : 4 - size % 4);
-  DEBUG_VAR("message size format in mpack", size);
-  char buf[size];
-  bzero(buf, size);
-  GString str = buf;
-  PrintAdapter streamer = str;
-  CoolMessagePack::jsonToMsgpck(streamer, root);
-  char *output;
-  if (!(output = (char *)malloc((size_t)size * 1.25 + 3))) {
-    ERROR_LOG("malloc return null");
-  }
-  output[0] = '"';
-  size_t index = Z85_encode(buf, &output[1], size);
-  output[index + 1] = '"';
-  output[index + 2] = '\0';
-  return (output);
+void CoolBoard::createLog(CoolTelemetry &telemetry) {
+  if (CoolSchema::getInstance().isActive()) {
+    telemetry.setSchema(&CoolSchema::getInstance());
+  }
+  telemetry.beginObject();
+  if (!this->batchActive) {
+    telemetry.beginObject("state");
+    telemetry.beginObject("reported");
+  }
+  this->readBoardData(telemetry);
+  this->readSensors(telemetry);
+  this->handleActuators(telemetry);
+  if (!this->batchActive) {
+    telemetry.endObject();
+    telemetry.endObject();
+  }
+  telemetry.endObject();
+  if (telemetry.failed()) {
+    ERROR_LOG("Failed to encode telemetry");
+  }
+  DEBUG_VAR("message size format in mpack", telemetry.size());
 }
 
 bool CoolBoard::isConnected() {
@@ -190,30 +280,276 @@ void CoolBoard::connect() {
 }
 
 void CoolBoard::sendSavedMessages() {
-  int savedLogNumber;
-  while ((savedLogNumber = CoolFileSystem::lastSavedLogNumber()) &&
-         !this->shouldLog()) {
-    INFO_VAR("Sending saved log number:", savedLogNumber);
-    String jsonData = CoolFileSystem::getSavedLogAsString(savedLogNumber);
-    DEBUG_VAR("Saved JSON data to send:", jsonData);
-    if (this->mqttPublish(jsonData)) {
-      CoolFileSystem::deleteSavedLog(savedLogNumber);
-      this->messageSent();
-    } else {
+  CoolBacklog &backlog = CoolBacklog::getInstance();
+  unsigned long start = millis();
+  float factor = this->drainFactor();
+  uint32_t records = backlog.count();
+  uint32_t bytes = backlog.bytes();
+  if (this->ackedDelivery) {
+    this->sendAcknowledged(start, factor);
+  }
+  while (!this->ackedDelivery && !backlog.isEmpty() && !this->shouldLog()) {
+    uint32_t drained = records - min(records, backlog.count());
+    uint32_t drainedBytes = bytes - min(bytes, backlog.bytes());
+
+    if (!this->drainAllowed(drained, drainedBytes, millis() - start,
+                            factor)) {
+      INFO_VAR("Drain budget spent, saved logs left:", backlog.count());
+      break;
+    }
+    CoolBacklogCursor cursor = backlog.head();
+    if (!this->sendSaved(cursor, NULL)) {
       this->networkProblem();
-      ERROR_LOG("MQTT publish failed, kept log on SPIFFS");
+      ERROR_LOG("MQTT publish failed, kept logs on SPIFFS");
+      break;
+    }
+    if (!backlog.commit(cursor)) {
+      ERROR_LOG("Failed to remove sent logs from the backlog");
       break;
     }
+    this->messageSent();
   }
+  CoolProfiler::getInstance().drained(records - min(records, backlog.count()),
+                                      bytes - min(bytes, backlog.bytes()));
 }
 
-void CoolBoard::handleActuators(JsonObject &root) {
+void CoolBoard::sendAcknowledged(unsigned long start, float factor) {
+  CoolBacklog &backlog = CoolBacklog::getInstance();
+  CoolBacklogCursor cursor = backlog.head();
+  CoolBacklogCursor window[ACK_WINDOW_MAX];
+  uint32_t sequences[ACK_WINDOW_MAX];
+  uint8_t inFlight = 0;
+  bool more = true;
+  unsigned long waiting = millis();
+
+  while (true) {
+    uint8_t acked = 0;
+
+    this->coolPubSubClient->loop();
+    // acknowledgements are cumulative, logs without a sequence need none
+    while (acked < inFlight &&
+           (sequences[acked] == 0 ||
+            (int32_t)(sequences[acked] - this->lastAck) <= 0)) {
+      acked++;
+    }
+    if (acked > 0) {
+      if (!backlog.commit(window[acked - 1])) {
+        ERROR_LOG("Failed to remove sent logs from the backlog");
+        break;
+      }
+      inFlight -= acked;
+      memmove(window, window + acked, inFlight * sizeof(window[0]));
+      memmove(sequences, sequences + acked, inFlight * sizeof(sequences[0]));
+      waiting = millis();
+      this->messageSent();
+    }
+    more = more && !this->shouldLog() &&
+           this->drainAllowed(cursor.count, cursor.bytes, millis() - start,
+                              factor);
+    if (more && inFlight < this->ackWindow) {
+      CoolBacklogCursor next = cursor;
+      uint32_t sequence = 0;
+
+      if (!this->sendSaved(next, &sequence)) {
+        this->networkProblem();
+        ERROR_LOG("MQTT publish failed, kept logs on SPIFFS");
+        break;
+      }
+      if (next.count == cursor.count) {
+        more = false;
+        continue;
+      }
+      cursor = next;
+      window[inFlight] = cursor;
+      sequences[inFlight] = sequence;
+      if (inFlight++ == 0) {
+        waiting = millis();
+      }
+      continue;
+    }
+    if (inFlight == 0) {
+      break;
+    }
+    if (millis() - waiting > this->ackTimeout) {
+      WARN_VAR("No acknowledgement, kept messages in flight:", inFlight);
+      break;
+    }
+    yield();
+  }
+}
+
+bool CoolBoard::sendSaved(CoolBacklogCursor &cursor, uint32_t *sequence) {
+  CoolBacklog &backlog = CoolBacklog::getInstance();
+  uint8_t *saved;
+  size_t size;
+
+  if (this->batchActive) {
+    return (this->sendFrame(NULL, 0, &cursor, sequence));
+  }
+  if (!backlog.read(cursor, saved, size)) {
+    return (true);
+  }
+  bool sent;
+  if (CoolBacklog::isBlock(saved, size)) {
+    size_t rawSize;
+    uint8_t samples;
+    uint8_t *raw = CoolBacklog::expand(saved, size, rawSize, samples);
+
+    sent = this->publishSavedBlock(raw, rawSize, sequence);
+    free(raw);
+  } else {
+    sent = this->publishSavedLog(saved, CoolBacklog::decode(saved, size),
+                                 sequence);
+  }
+  free(saved);
+  return (sent);
+}
+
+bool CoolBoard::publishLive(const uint8_t *data, size_t size, bool batch) {
+  uint32_t sequence = 0;
+
+  if (this->liveCount == ACK_WINDOW_MAX) {
+    WARN_LOG("Live window full, saving the oldest log");
+    this->ackLive();
+  }
+  if (this->liveCount == ACK_WINDOW_MAX) {
+    CoolLiveLog &oldest = this->live[0];
+
+    this->saveLog(oldest.data, oldest.size);
+    free(oldest.data);
+    this->liveCount--;
+    memmove(this->live, this->live + 1,
+            this->liveCount * sizeof(this->live[0]));
+  }
+  bool sent = batch ? this->sendFrame(data, size, NULL, &sequence)
+                    : this->publishSequenced(data, size, false, &sequence);
+  if (!sent || sequence == 0) {
+    return (sent);
+  }
+  uint8_t *copy = (uint8_t *)malloc(size);
+  if (copy == NULL) {
+    // without a copy the log can only be kept safe in the backlog
+    this->saveLog(data, size);
+    return (true);
+  }
+  memcpy(copy, data, size);
+  this->live[this->liveCount++] = {copy, size, sequence, millis()};
+  return (true);
+}
+
+void CoolBoard::ackLive() {
+  uint8_t acked = 0;
+
+  // acknowledgements are cumulative and live logs are sent in order
+  while (acked < this->liveCount &&
+         (int32_t)(this->live[acked].sequence - this->lastAck) <= 0) {
+    free(this->live[acked].data);
+    acked++;
+  }
+  if (acked > 0) {
+    this->liveCount -= acked;
+    memmove(this->live, this->live + acked,
+            this->liveCount * sizeof(this->live[0]));
+  }
+}
+
+void CoolBoard::settleLive() {
+  this->ackLive();
+  while (this->liveCount > 0 &&
+         millis() - this->live[this->liveCount - 1].sent <= this->ackTimeout &&
+         this->isConnected()) {
+    this->coolPubSubClient->loop();
+    this->ackLive();
+    yield();
+  }
+  if (this->liveCount == 0) {
+    return;
+  }
+  WARN_VAR("No acknowledgement, saved live logs:", this->liveCount);
+  for (uint8_t i = 0; i < this->liveCount; i++) {
+    this->saveLog(this->live[i].data, this->live[i].size);
+    free(this->live[i].data);
+  }
+  this->liveCount = 0;
+}
+
+void CoolBoard::saveLog(const uint8_t *data, size_t size) {
+  CoolTelemetry stamped;
+
+  // frame headers describe the firmware and schema of the sending wake
+  if (this->batchActive && CoolFrame::stamp(stamped, data, size)) {
+    CoolBacklog::getInstance().append(stamped.data(), stamped.size());
+  } else {
+    CoolBacklog::getInstance().append(data, size);
+  }
+}
+
+uint32_t CoolBoard::nextSequence() {
+  if (++this->sequence == 0) {
+    this->sequence = 1;
+  }
+  return (this->sequence);
+}
+
+float CoolBoard::drainFactor() {
+  if (!this->drainAdaptive) {
+    return (1);
+  }
+  if (this->batteryVoltage < NOT_IN_CHARGING) {
+    return (DRAIN_CHARGING_FACTOR);
+  }
+  float level = (this->batteryVoltage - MIN_BAT_VOLTAGE) /
+                (FULL_BAT_VOLTAGE - MIN_BAT_VOLTAGE);
+  level = constrain(level, 0, 1);
+  return (DRAIN_LOW_FACTOR + (1 - DRAIN_LOW_FACTOR) * level);
+}
+
+bool CoolBoard::drainAllowed(uint32_t messages, uint32_t bytes,
+                             unsigned long elapsed, float factor) {
+  // a zero limit is no limit, and the first log is always sent
+  return ((this->drainMessages == 0 ||
+           messages < this->drainMessages * factor) &&
+          (this->drainBytes == 0 || bytes < this->drainBytes * factor) &&
+          (this->drainMillis == 0 || elapsed < this->drainMillis * factor));
+}
+
+bool CoolBoard::publishSavedLog(const uint8_t *data, size_t packed,
+                                uint32_t *sequence) {
+  if (packed > 0) {
+    return (this->publishSequenced(data, packed, false, sequence));
+  }
+  if (data != NULL && data[0] == '{') {
+    DEBUG_VAR("Saved JSON data to send:", (const char *)data);
+    return (this->mqttPublish(String((const char *)data)));
+  }
+  ERROR_LOG("Dropping unreadable saved log");
+  return (true);
+}
+
+bool CoolBoard::publishSavedBlock(const uint8_t *raw, size_t size,
+                                  uint32_t *sequence) {
+  if (raw == NULL) {
+    ERROR_LOG("Dropping unreadable saved logs");
+    return (true);
+  }
+  for (size_t offset = 0; offset < size;) {
+    size_t packed = CoolMessagePack::objectSize(raw + offset, size - offset);
+
+    if (packed == 0 ||
+        !this->publishSavedLog(raw + offset, packed, sequence)) {
+      return (packed == 0);
+    }
+    offset += packed;
+  }
+  return (true);
+}
+
+void CoolBoard::handleActuators(CoolTelemetry &telemetry) {
   if (this->manual == 0) {
     Date date = CoolTime::getInstance().rtc.getDate();
-    root.createNestedArray("actuators");
     INFO_LOG("Actuators configuration: automatic");
     DEBUG_LOG("Updating and recording Jetpack state...");
-    this->jetPack.doAction(root, date.getHour(), date.getMinutes());
+    this->jetPack.doAction(telemetry, date.getHour(), date.getMinutes());
     DEBUG_LOG("Updating and recording onboard actuator state...");
   } else {
     INFO_LOG("Actuators configuration: manual");
@@ -235,14 +571,6 @@ unsigned long CoolBoard::secondsToNextLog() {
   return (seconds > this->logInterval ? this->logInterval : seconds);
 }
 
-int CoolBoard::b64decode(String b64Text, uint8_t *output) {
-  base64_decodestate s;
-  base64_init_decodestate(&s);
-  int cnt = base64_decode_block(b64Text.c_str(), b64Text.length(),
-                                (char *)output, &s);
-  return cnt;
-}
-
 bool CoolBoard::config() {
   INFO_VAR("MAC address is:", WiFi.macAddress());
   INFO_VAR("Firmware version is:", COOL_FW_VERSION);
@@ -260,16 +588,124 @@ bool CoolBoard::config() {
   CoolConfig::set<bool>(general, "sleepActive", this->sleepActive);
   CoolConfig::set<bool>(general, "manual", this->manual);
   CoolConfig::set<String>(general, "mqttServer", this->mqttServer);
+  CoolConfig::set<bool>(general, "batchRecords", this->batchActive);
+  String transport = this->binaryTransport ? "binary" : "z85";
+  CoolConfig::set<String>(general, "transport", transport);
+  this->binaryTransport = (transport == "binary");
+  CoolConfig::set<bool>(general, "ackedDelivery", this->ackedDelivery);
+  CoolConfig::set<uint8_t>(general, "ackWindow", this->ackWindow);
+  CoolConfig::set<uint32_t>(general, "ackTimeout", this->ackTimeout);
+  this->ackWindow = constrain(this->ackWindow, 1, ACK_WINDOW_MAX);
+  this->sequence = RANDOM_REG32;
+  this->lastAck = this->sequence;
+  JsonObject &drain = general["drain"];
+  CoolConfig::set<uint32_t>(drain, "messages", this->drainMessages);
+  CoolConfig::set<uint32_t>(drain, "bytes", this->drainBytes);
+  CoolConfig::set<uint32_t>(drain, "millis", this->drainMillis);
+  CoolConfig::set<bool>(drain, "adaptive", this->drainAdaptive);
+  CoolProfiler::getInstance().config(general["phaseCurrent"]);
+  CoolSchema::getInstance().config(general);
+  CoolBacklog::getInstance().config(general["backlog"]);
   INFO_LOG("Main configuration loaded");
   return (true);
 }
 
+bool CoolBoard::restoreConfig(uint32_t hash) {
+  CoolSnapshot snapshot;
+
+  if (!snapshot.load(hash)) {
+    return (false);
+  }
+  INFO_VAR("MAC address is:", WiFi.macAddress());
+  INFO_VAR("Firmware version is:", COOL_FW_VERSION);
+  if (!this->coolBoardLed.restore(snapshot) || !this->restore(snapshot) ||
+      !this->coolWifi->restore(snapshot) ||
+      !CoolProfiler::getInstance().restore(snapshot) ||
+      !CoolBacklog::getInstance().restore(snapshot) ||
+      !this->coolBoardSensors.restore(snapshot) ||
+      !this->jetPack.restore(snapshot) || !this->irene3000.restore(snapshot) ||
+      !this->externalSensors->restore(snapshot) ||
+      !CoolSchema::getInstance().restore(snapshot)) {
+    ERROR_LOG("Configuration snapshot is corrupted, restarting");
+    SPIFFS.remove(SNAPSHOT_PATH);
+    ESP.restart();
+  }
+  CoolSnapshot::remember(hash);
+  INFO_LOG("Configuration restored from snapshot");
+  return (true);
+}
+
+void CoolBoard::saveConfig() {
+  CoolSnapshot snapshot;
+
+  this->coolBoardLed.snapshot(snapshot);
+  this->snapshot(snapshot);
+  this->coolWifi->snapshot(snapshot);
+  CoolProfiler::getInstance().snapshot(snapshot);
+  CoolBacklog::getInstance().snapshot(snapshot);
+  this->coolBoardSensors.snapshot(snapshot);
+  this->jetPack.snapshot(snapshot);
+  this->irene3000.snapshot(snapshot);
+  this->externalSensors->snapshot(snapshot);
+  CoolSchema::getInstance().snapshot(snapshot);
+  uint32_t hash = CoolSnapshot::hash();
+  if (snapshot.save(hash)) {
+    CoolSnapshot::remember(hash);
+  }
+}
+
+void CoolBoard::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->logInterval);
+  snapshot.put(this->sleepActive);
+  snapshot.put(this->manual);
+  snapshot.put(this->mqttServer);
+  snapshot.put(this->batchActive);
+  snapshot.put(this->binaryTransport);
+  snapshot.put(this->ackedDelivery);
+  snapshot.put(this->ackWindow);
+  snapshot.put(this->ackTimeout);
+  snapshot.put(this->drainMessages);
+  snapshot.put(this->drainBytes);
+  snapshot.put(this->drainMillis);
+  snapshot.put(this->drainAdaptive);
+}
+
+bool CoolBoard::restore(CoolSnapshot &snapshot) {
+  snapshot.get(this->logInterval);
+  snapshot.get(this->sleepActive);
+  snapshot.get(this->manual);
+  snapshot.get(this->mqttServer);
+  snapshot.get(this->batchActive);
+  snapshot.get(this->binaryTransport);
+  snapshot.get(this->ackedDelivery);
+  snapshot.get(this->ackWindow);
+  snapshot.get(this->ackTimeout);
+  snapshot.get(this->drainMessages);
+  snapshot.get(this->drainBytes);
+  snapshot.get(this->drainMillis);
+  snapshot.get(this->drainAdaptive);
+  this->sequence = RANDOM_REG32;
+  this->lastAck = this->sequence;
+  return (snapshot.isValid());
+}
+
 void CoolBoard::printConf() {
   INFO_LOG("General configuration");
   INFO_VAR("  Log interval            =", this->logInterval);
   INFO_VAR("  Sleep active            =", this->sleepActive);
   INFO_VAR("  Manual active           =", this->manual);
   INFO_VAR("  MQTT server:            =", this->mqttServer);
+  INFO_VAR("  Batch records           =", this->batchActive);
+  INFO_VAR("  Binary transport        =", this->binaryTransport);
+  INFO_VAR("  Acked delivery          =", this->ackedDelivery);
+  INFO_VAR("  Ack window              =", this->ackWindow);
+  INFO_VAR("  Ack timeout             =", this->ackTimeout);
+  INFO_VAR("  Drain messages          =", this->drainMessages);
+  INFO_VAR("  Drain bytes             =", this->drainBytes);
+  INFO_VAR("  Drain milliseconds      =", this->drainMillis);
+  INFO_VAR("  Adaptive drain          =", this->drainAdaptive);
+  CoolProfiler::getInstance().printConf();
+  CoolBacklog::getInstance().printConf();
 }
 
 bool CoolBoard::update(String &answer) {
@@ -371,34 +807,51 @@ bool CoolBoard::update(String &answer) {
 
 unsigned long CoolBoard::getLogInterval() { return (this->logInterval); }
 
-void CoolBoard::readSensors(JsonObject &root) {
-  JsonObject &sample = root.createNestedObject("sample");
+void CoolBoard::readSensors(CoolTelemetry &telemetry) {
+  telemetry.beginObject("sample");
   digitalWrite(ENABLE_I2C_PIN, HIGH);
-  this->coolBoardSensors.read(sample);
-  this->externalSensors->read(sample);
-  this->irene3000.read(sample);
+  this->coolBoardSensors.read(telemetry);
+  this->externalSensors->read(telemetry);
+  this->irene3000.read(telemetry);
+  telemetry.endObject();
   this->coolBoardLed.blink(GREEN, 0.5);
 }
 
-void CoolBoard::readBoardData(JsonObject &root) {
-  root["timestamp"] = CoolTime::getInstance().getIso8601DateTime();
-  JsonObject &stat = root.createNestedObject("static");
-  JsonObject &general = root.createNestedObject("system");
+void CoolBoard::readBoardData(CoolTelemetry &telemetry) {
+  telemetry.add("timestamp", CoolTime::getInstance().getIso8601DateTime());
+  if (!this->batchActive) {
+    telemetry.beginObject("static");
+    telemetry.add("macAddress", this->mqttId);
+    telemetry.endObject();
+  }
+  telemetry.beginObject("system");
   if (WiFi.status() == WL_CONNECTED) {
     String ip;
     if (this->coolWifi->getPublicIp(ip)) {
       DEBUG_VAR("Public IP address:", ip);
-      general["publicIp"] = ip;
+      telemetry.add("publicIp", ip);
+    }
+  }
+  if (!this->batchActive) {
+    telemetry.add("fwVersion", COOL_FW_VERSION);
+    if (CoolSchema::getInstance().isActive()) {
+      telemetry.add("schema", CoolSchema::getInstance().hash());
     }
   }
-  general["fwVersion"] = COOL_FW_VERSION;
   if (WiFi.status() == WL_CONNECTED) {
-    general["wifiSignal"] = WiFi.RSSI();
+    telemetry.add("wifiSignal", WiFi.RSSI());
+  }
+  if (CoolConfig::peakHeap() > 0) {
+    telemetry.add("configPeak", CoolConfig::peakHeap());
   }
-  stat["macAddress"] = this->mqttId;
+  CoolProfiler::getInstance().report(telemetry);
+  telemetry.endObject();
 }
 
 void CoolBoard::sleep() {
+  CoolProfiler &profiler = CoolProfiler::getInstance();
+
+  profiler.start(PHASE_SLEEP);
   EEPROM.begin(5);
   uint8_t val[4];
   rst_info *resetInfo;
@@ -426,6 +879,7 @@ void CoolBoard::sleep() {
         EEPROM.write(i, val[i]);
       }
       EEPROM.end();
+      profiler.commit();
       ESP.deepSleep((uint64_t(MAX_SLEEP_TIME) * 1000000ULL), WAKE_RF_DEFAULT);
     } else {
       INFO_VAR("Going to sleep for:", value);
@@ -433,10 +887,12 @@ void CoolBoard::sleep() {
         EEPROM.write(i, 0);
       }
       EEPROM.end();
+      profiler.commit();
       ESP.deepSleep((uint64_t(value) * 1000000ULL), WAKE_RF_DEFAULT);
     }
   }
   EEPROM.end();
+  profiler.stop(PHASE_SLEEP);
 }
 
 void CoolBoard::parseJsonConfig(const char *filePath, JsonObject &send) {
@@ -456,19 +912,35 @@ void CoolBoard::sendConfig(const char *path) {
   DynamicJsonBuffer buffer;
   JsonObject &json = buffer.createObject();
   parseJsonConfig(path, json);
-  size_t size = CoolMessagePack::sizeJsonToMsgpck(json);
-  size = size + (size % 4 == 0 ? 0 : 4 - size % 4);
-  DEBUG_VAR("message size format in mpack", size);
-  char buf[size];
-  GString str = buf;
-  PrintAdapter streamer = str;
-  CoolMessagePack::jsonToMsgpck(streamer, json);
-  char output[(size_t)(size * 1.25 + 3)];
-  output[0] = '"';
-  int index = Z85_encode(buf, &output[1], size);
-  output[index + 1] = '"';
-  output[index + 2] = '\0';
-  this->mqttLog(output, 1);
+  CoolTelemetry telemetry;
+  CoolMessagePack::writeJson(telemetry, json);
+  DEBUG_VAR("message size format in mpack", telemetry.size());
+  this->mqttLog(telemetry.data(), telemetry.size());
+}
+
+void CoolBoard::sendSchema() {
+  CoolSchema &schema = CoolSchema::getInstance();
+
+  if (!schema.shouldPublish() || !this->isConnected()) {
+    return;
+  }
+  CoolTelemetry telemetry;
+  telemetry.beginObject();
+  telemetry.beginObject("state");
+  telemetry.beginObject("reported");
+  telemetry.beginObject("static");
+  telemetry.add("macAddress", this->mqttId);
+  telemetry.endObject();
+  schema.report(telemetry);
+  telemetry.endObject();
+  telemetry.endObject();
+  telemetry.endObject();
+  if (this->mqttPublish(telemetry.data(), telemetry.size())) {
+    INFO_VAR("Published telemetry schema:", schema.hash());
+    schema.published();
+  } else {
+    WARN_LOG("Failed to publish telemetry schema");
+  }
 }
 
 void CoolBoard::sendAllConfig() {
@@ -505,14 +977,19 @@ void CoolBoard::spiffsProblem() {
 
 void CoolBoard::lowBattery() {
   WiFi.mode(WIFI_OFF);
+  if (CoolBacklog::getInstance().staged() > 0 && SPIFFS.begin()) {
+    CoolBacklog::getInstance().flush();
+  }
   SPIFFS.end();
+  CoolProfiler::getInstance().commit();
   ESP.deepSleep((uint64_t(LOW_POWER_SLEEP) * 1000000ULL), WAKE_RF_DEFAULT);
 }
 
 void CoolBoard::powerCheck() {
-  float batteryVoltage = this->coolBoardSensors.readVBat();
-  if (!(batteryVoltage < NOT_IN_CHARGING || batteryVoltage > MIN_BAT_VOLTAGE)) {
-    DEBUG_VAR("Battery voltage:", batteryVoltage);
+  this->batteryVoltage = this->coolBoardSensors.readVBat();
+  if (!(this->batteryVoltage < NOT_IN_CHARGING ||
+        this->batteryVoltage > MIN_BAT_VOLTAGE)) {
+    DEBUG_VAR("Battery voltage:", this->batteryVoltage);
     WARN_LOG("Battery Power is low! Need to charge!");
     this->lowBattery();
   }
@@ -563,14 +1040,23 @@ void CoolBoard::mqttConnect() {
   INFO_LOG("MQTT connecting...");
   DEBUG_VAR("MQTT client id:", this->mqttId);
   while (!this->coolPubSubClient->connected() && i < MQTT_RETRIES) {
-    this->mqttsConfig();
+    if (!this->mqttsInstalled && !this->mqttsInstall()) {
+      return;
+    }
     INFO_LOG("start mqtt connection");
     if (this->coolPubSubClient->connect(this->mqttId.c_str())) {
       this->coolPubSubClient->subscribe(this->mqttInTopic.c_str());
       INFO_LOG("Subscribed to MQTT input topic");
+      if (this->ackedDelivery) {
+        this->coolPubSubClient->subscribe(this->mqttAckTopic.c_str());
+      }
       mqttRetries = 0;
     } else {
       WARN_LOG("MQTT connection failed, retrying");
+      // axTLS frees its context, and the credentials, when TLS fails
+      if (this->coolPubSubClient->state() == MQTT_CONNECT_FAILED) {
+        this->mqttsInstalled = false;
+      }
       mqttRetries++;
     }
     delay(5);
@@ -591,7 +1077,50 @@ void CoolBoard::mqttLog(String data, bool mpack) {
     messageSent = this->mqttPublish(data, mpack);
   }
   if (!messageSent) {
-    CoolFileSystem::saveLogToFile(data.c_str());
+    CoolBacklog::getInstance().append((const uint8_t *)data.c_str(),
+                                      data.length());
+    this->networkProblem();
+    WARN_LOG("Log not sent, saved on SPIFFS");
+  } else {
+    INFO_LOG("MQTT publish successful");
+    this->messageSent();
+  }
+}
+
+void CoolBoard::mqttLog(const uint8_t *data, size_t size) {
+  bool messageSent = false;
+
+  DEBUG_VAR("Message size:", size);
+  if (this->isConnected()) {
+    messageSent = this->ackedDelivery ? this->publishLive(data, size, false)
+                                      : this->mqttPublish(data, size);
+  }
+  if (!messageSent) {
+    this->saveLog(data, size);
+    this->networkProblem();
+    WARN_LOG("Log not sent, saved on SPIFFS");
+  } else {
+    INFO_LOG("MQTT publish successful");
+    this->messageSent();
+  }
+}
+
+void CoolBoard::mqttBatch(const uint8_t *data, size_t size) {
+  bool messageSent = false;
+
+  DEBUG_VAR("Sample size:", size);
+  if (this->isConnected() && this->ackedDelivery) {
+    messageSent = this->publishLive(data, size, true);
+  } else if (this->isConnected()) {
+    CoolBacklogCursor cursor = CoolBacklog::getInstance().head();
+
+    messageSent = this->sendFrame(data, size, &cursor);
+    if (messageSent && !CoolBacklog::getInstance().commit(cursor)) {
+      ERROR_LOG("Failed to remove sent logs from the backlog");
+    }
+  }
+  if (!messageSent) {
+    this->saveLog(data, size);
     this->networkProblem();
     WARN_LOG("Log not sent, saved on SPIFFS");
   } else {
@@ -600,6 +1129,160 @@ void CoolBoard::mqttLog(String data, bool mpack) {
   }
 }
 
+bool CoolBoard::sendFrame(const uint8_t *data, size_t size,
+                          CoolBacklogCursor *cursor, uint32_t *sequence) {
+  CoolBacklog &backlog = CoolBacklog::getInstance();
+  const String &topic = this->binaryTransport ? this->mqttOutRawBatchTopic
+                                              : this->mqttOutBatchTopic;
+  CoolFrame frame(MQTT_MAX_PACKET_SIZE - MQTT_PUBLISH_OVERHEAD -
+                      topic.length() -
+                      (sequence != NULL ? MQTT_SEQUENCE_OVERHEAD : 0),
+                  !this->binaryTransport);
+
+  frame.begin(this->mqttId);
+  if (data != NULL) {
+    frame.add(data, size);
+  }
+  // without a cursor the frame only holds the given sample
+  while (cursor != NULL && frame.count() < FRAME_MAX_SAMPLES) {
+    CoolBacklogCursor next = *cursor;
+    uint8_t *saved;
+    size_t savedSize;
+
+    if (!backlog.read(next, saved, savedSize)) {
+      *cursor = next;
+      break;
+    }
+    if (CoolBacklog::isBlock(saved, savedSize)) {
+      size_t rawSize = 0;
+      uint8_t samples = 0;
+      uint8_t *raw = CoolBacklog::expand(saved, savedSize, rawSize, samples);
+
+      free(saved);
+      if (raw != NULL && CoolFrame::isSample(raw, rawSize)) {
+        // a block is sent whole, so that it can be committed at once
+        if (frame.count() > 0 && !frame.fits(rawSize, samples)) {
+          free(raw);
+          break;
+        }
+        for (size_t offset = 0; offset < rawSize;) {
+          size_t sample =
+              CoolMessagePack::objectSize(raw + offset, rawSize - offset);
+          if (sample == 0) {
+            break;
+          }
+          frame.add(raw + offset, sample, true);
+          offset += sample;
+        }
+        free(raw);
+        *cursor = next;
+        continue;
+      }
+      if (frame.count() > 0) {
+        free(raw);
+        break;
+      }
+      bool sent = this->publishSavedBlock(raw, rawSize, sequence);
+      free(raw);
+      if (sent) {
+        *cursor = next;
+      }
+      return (sent);
+    }
+    size_t packed = CoolBacklog::decode(saved, savedSize);
+    if (!CoolFrame::isSample(saved, packed)) {
+      if (frame.count() > 0) {
+        free(saved);
+        break;
+      }
+      bool sent = this->publishSavedLog(saved, packed, sequence);
+      free(saved);
+      if (sent) {
+        *cursor = next;
+      }
+      return (sent);
+    }
+    bool added = frame.add(saved, packed);
+    free(saved);
+    if (!added) {
+      break;
+    }
+    *cursor = next;
+  }
+  frame.end();
+  if (frame.count() == 0) {
+    return (true);
+  }
+  if (frame.failed() ||
+      !this->publishSequenced(frame.data(), frame.size(), true, sequence)) {
+    return (false);
+  }
+  INFO_VAR("Published samples in one frame:", frame.count());
+  return (true);
+}
+
+bool CoolBoard::publishSequenced(const uint8_t *data, size_t size, bool batch,
+                                 uint32_t *sequence) {
+  CoolTelemetry message;
+  uint32_t count;
+  size_t header;
+
+  if (sequence == NULL) {
+    return (this->mqttPublish(data, size, batch));
+  }
+  if (size > 0 && (data[0] & 0xf0) == 0x80) {
+    count = data[0] & 0x0f;
+    header = 1;
+  } else if (size > 2 && data[0] == 0xde) {
+    count = (data[1] << 8) | data[2];
+    header = 3;
+  } else {
+    return (this->mqttPublish(data, size, batch));
+  }
+  // one more "seq" entry at the end of the top level map
+  int id = CoolSchema::getInstance().isActive()
+               ? CoolSchema::getInstance().id("seq")
+               : -1;
+  *sequence = this->nextSequence();
+  CoolMessagePack::writeMapHeader(message, count + 1);
+  message.write(data + header, size - header);
+  if (id >= 0) {
+    CoolMessagePack::writeInteger(message, (uint8_t)id);
+  } else {
+    CoolMessagePack::writeString(message, "seq");
+  }
+  CoolMessagePack::writeInteger(message, *sequence);
+  return (!message.failed() &&
+          this->mqttPublish(message.data(), message.size(), batch));
+}
+
+bool CoolBoard::mqttPublish(const uint8_t *data, size_t size, bool batch) {
+  const String &topic =
+      this->binaryTransport
+          ? (batch ? this->mqttOutRawBatchTopic : this->mqttOutRawTopic)
+          : (batch ? this->mqttOutBatchTopic : this->mqttOutMpackTopic);
+  size_t length = this->binaryTransport ? size : CoolZ85::encodedSize(size);
+  bool published = false;
+
+  // header and payload are written piecewise, send them as one TLS record
+  if (!this->mqttClient->hold(MQTT_PUBLISH_OVERHEAD + topic.length() +
+                              length)) {
+    return (false);
+  }
+  if (this->coolPubSubClient->beginPublish(topic.c_str(), length, false)) {
+    if (this->binaryTransport) {
+      published = this->coolPubSubClient->write(data, size) == size;
+    } else {
+      CoolZ85 z85(*this->coolPubSubClient);
+
+      z85.write(data, size);
+      published = z85.end() == length && !z85.failed();
+    }
+    published = this->coolPubSubClient->endPublish() && published;
+  }
+  return (this->mqttClient->release() && published);
+}
+
 bool CoolBoard::mqttPublish(String data, bool mpack) {
   if (!mpack) {
     return (this->coolPubSubClient->publish(this->mqttOutTopic.c_str(),
@@ -622,6 +1305,19 @@ bool CoolBoard::mqttListen() {
 }
 
 void CoolBoard::mqttCallback(char *topic, byte *payload, unsigned int length) {
+  if (this->ackedDelivery && strcmp(topic, this->mqttAckTopic.c_str()) == 0) {
+    char text[12];
+    size_t size = min((size_t)length, sizeof(text) - 1);
+
+    memcpy(text, payload, size);
+    text[size] = '\0';
+    uint32_t ack = strtoul(text, NULL, 10);
+    if ((int32_t)(ack - this->lastAck) > 0 &&
+        (int32_t)(ack - this->sequence) <= 0) {
+      this->lastAck = ack;
+    }
+    return;
+  }
   this->updateAnswer = (char)payload[0];
   for (unsigned int i = 1; i < length; i++) {
     this->updateAnswer += (char)payload[i];
@@ -629,28 +1325,157 @@ void CoolBoard::mqttCallback(char *topic, byte *payload, unsigned int length) {
   this->updateAnswer += '\0';
 }
 
-void CoolBoard::mqttsConvert(String cert) {
-  File bin = SPIFFS.open(cert, "r");
-  String certficateString = bin.readString();
+bool CoolBoard::mqttsConvert(const char *path, uint8_t *&der, size_t &size,
+                             uint32_t &source) {
+  base64_decodestate state;
+  char chunk[64];
+  size_t length;
+
+  File bin = SPIFFS.open(path, "r");
+  if (!bin) {
+    return (false);
+  }
+  der = (uint8_t *)malloc(bin.size() * 3 / 4 + 3);
+  if (der == NULL) {
+    bin.close();
+    return (false);
+  }
+  size = 0;
+  base64_init_decodestate(&state);
+  while ((length = bin.read((uint8_t *)chunk, sizeof(chunk))) > 0) {
+    source = CoolCrc32::update(source, chunk, length);
+    size += base64_decode_block(chunk, length, (char *)der + size, &state);
+  }
   bin.close();
-  DEBUG_LOG("Closing bin file");
-  uint8_t binaryCert[certficateString.length()];
-  uint16_t len = this->b64decode(certficateString, binaryCert);
-  if (strstr(cert.c_str(), "certificate")) {
-    this->wifiClientSecure->setCertificate(binaryCert, len);
-  } else {
-    this->wifiClientSecure->setPrivateKey(binaryCert, len);
+  DEBUG_VAR("Decoded DER bytes:", size);
+  return (size > 0);
+}
+
+uint32_t CoolBoard::mqttsChecksum() {
+  uint32_t crc = CoolCrc32::update(0, this->certificate, this->certificateSize);
+
+  return (CoolCrc32::update(crc, this->privateKey, this->privateKeySize));
+}
+
+bool CoolBoard::mqttsRecall() {
+  CoolMqttsHeader header;
+  File file = SPIFFS.open(MQTTS_DER_PATH, "r");
+
+  if (!file) {
+    return (false);
+  }
+  bool valid = file.read((uint8_t *)&header, sizeof(header)) ==
+                   sizeof(header) &&
+               header.magic == MQTTS_DER_MAGIC &&
+               file.size() == sizeof(header) + header.certificateSize +
+                                  header.privateKeySize;
+  if (valid) {
+    this->certificate = (uint8_t *)malloc(header.certificateSize);
+    this->privateKey = (uint8_t *)malloc(header.privateKeySize);
+    this->certificateSize = header.certificateSize;
+    this->privateKeySize = header.privateKeySize;
+    valid = this->certificate && this->privateKey &&
+            file.read(this->certificate, this->certificateSize) ==
+                this->certificateSize &&
+            file.read(this->privateKey, this->privateKeySize) ==
+                this->privateKeySize &&
+            this->mqttsChecksum() == header.crc;
+  }
+  file.close();
+  if (!valid) {
+    WARN_VAR("Decoding credentials again, invalid file:", MQTTS_DER_PATH);
+    free(this->certificate);
+    free(this->privateKey);
+    this->certificate = NULL;
+    this->privateKey = NULL;
+    return (false);
   }
+  DEBUG_VAR("Loaded DER credentials from:", MQTTS_DER_PATH);
+  return (true);
+}
+
+void CoolBoard::mqttsStore(uint32_t source) {
+  CoolMqttsHeader header;
+  File file = SPIFFS.open(MQTTS_DER_PATH, "r");
+  uint32_t crc = this->mqttsChecksum();
+
+  if (file) {
+    bool current = file.read((uint8_t *)&header, sizeof(header)) ==
+                       sizeof(header) &&
+                   header.magic == MQTTS_DER_MAGIC && header.source == source &&
+                   header.crc == crc;
+    file.close();
+    if (current) {
+      return;
+    }
+  }
+  header.magic = MQTTS_DER_MAGIC;
+  header.source = source;
+  header.crc = crc;
+  header.certificateSize = this->certificateSize;
+  header.privateKeySize = this->privateKeySize;
+  String temp = String(MQTTS_DER_PATH) + CONFIG_TEMP_SUFFIX;
+  file = SPIFFS.open(temp, "w");
+  if (!file) {
+    ERROR_VAR("Failed to open file for writing:", temp);
+    return;
+  }
+  bool written =
+      file.write((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+      file.write(this->certificate, this->certificateSize) ==
+          this->certificateSize &&
+      file.write(this->privateKey, this->privateKeySize) ==
+          this->privateKeySize;
+  file.close();
+  if (!written || (SPIFFS.exists(MQTTS_DER_PATH) &&
+                   !SPIFFS.remove(MQTTS_DER_PATH)) ||
+      !SPIFFS.rename(temp.c_str(), MQTTS_DER_PATH)) {
+    ERROR_VAR("Failed to write file:", MQTTS_DER_PATH);
+    SPIFFS.remove(temp);
+    return;
+  }
+  DEBUG_VAR("Saved DER credentials to:", MQTTS_DER_PATH);
 }
 
-void CoolBoard::mqttsConfig() {
-  if (SPIFFS.exists("/certificate.bin") && SPIFFS.exists("/privateKey.bin")) {
+bool CoolBoard::mqttsInstall() {
+  if (this->certificate == NULL || this->privateKey == NULL) {
+    ERROR_LOG("No X509 certificate and private key to install");
+    return (false);
+  }
+  DEBUG_LOG("Installing X509 certificate and private key");
+  this->wifiClientSecure->setCertificate(this->certificate,
+                                         this->certificateSize);
+  this->wifiClientSecure->setPrivateKey(this->privateKey,
+                                        this->privateKeySize);
+  this->mqttsInstalled = true;
+  return (true);
+}
+
+void CoolBoard::mqttsConfig(bool warm) {
+  // the credentials only change with a new SPIFFS image, which is a cold
+  // boot: warm wakes trust the DER copy without reading the base64 files
+  bool loaded = warm && this->mqttsRecall();
+
+  if (!loaded) {
+    uint32_t source = 0;
     DEBUG_LOG("Loading X509 certificate");
-    this->mqttsConvert("/certificate.bin");
+    loaded = this->mqttsConvert("/certificate.bin", this->certificate,
+                                this->certificateSize, source);
     DEBUG_LOG("Loading X509 private key");
-    this->mqttsConvert("/privateKey.bin");
+    loaded = loaded && this->mqttsConvert("/privateKey.bin", this->privateKey,
+                                          this->privateKeySize, source);
+    if (loaded) {
+      this->mqttsStore(source);
+    } else {
+      free(this->certificate);
+      free(this->privateKey);
+      this->certificate = NULL;
+      this->privateKey = NULL;
+    }
+  }
+  if (loaded && this->mqttsInstall()) {
     DEBUG_LOG("Configuring MQTT");
-    this->coolPubSubClient->setClient(*this->wifiClientSecure);
+    this->coolPubSubClient->setClient(*this->mqttClient);
     this->coolPubSubClient->setServer(this->mqttServer.c_str(), 8883);
     this->coolPubSubClient->setCallback(
         [this](char *topic, byte *payload, unsigned int length) {
@@ -662,7 +1487,12 @@ void CoolBoard::mqttsConfig() {
         String(F("$aws/things/")) + this->mqttId + String(F("/shadow/update"));
     this->mqttInTopic =
         String(F("things/")) + this->mqttId + String(F("/shadow/update/delta"));
+    this->mqttAckTopic =
+        String(F("things/")) + this->mqttId + String(F("/ack"));
     this->mqttOutMpackTopic = String(F("BoardMessage/record"));
+    this->mqttOutBatchTopic = String(F("BoardMessage/batch"));
+    this->mqttOutRawTopic = String(F("BoardMessage/rawRecord"));
+    this->mqttOutRawBatchTopic = String(F("BoardMessage/rawBatch"));
   } else {
     ERROR_LOG("Certificate & Key binaries not found");
     DEBUG_VAR("/certificate.bin exist return: ",
@@ -705,6 +1535,7 @@ void CoolBoard::updateFirmware(String firmwareVersion, String firmwareUrl,
   this->coolBoardLed.write(ORANGE);
   delete this->coolPubSubClient;
   delete this->externalSensors;
+  delete this->mqttClient;
   delete this->wifiClientSecure;
   SPIFFS.remove("/otaUpdateConfig.json");
   SPIFFS.end();
@@ -26,10 +26,13 @@
 
 #include <Arduino.h>
 
+#include "CoolBacklog.h"
+#include "CoolBatchClient.h"
 #include "CoolBoardActuator.h"
 #include "CoolBoardLed.h"
 #include "CoolBoardSensors.h"
 #include "CoolFileSystem.h"
+#include "CoolFrame.h"
 #include "CoolTime.h"
 #include "CoolWifi.h"
 #include "ExternalSensors.h"
@@ -39,23 +42,58 @@
 #include <ESP8266HTTPClient.h>
 #include <ESP8266httpUpdate.h>
 #include "CoolMessagePack.h"
+#include "CoolTelemetry.h"
+#include "CoolSchema.h"
+#include "CoolSnapshot.h"
+#include "CoolZ85.h"
 #include "z85.h"
 
 #define ENABLE_I2C_PIN 5
 #define BOOTSTRAP_PIN 0
 #define MIN_BAT_VOLTAGE 3.5
 #define NOT_IN_CHARGING 1.8
+#define FULL_BAT_VOLTAGE 4.2
+#define DRAIN_CHARGING_FACTOR 4.
+#define DRAIN_LOW_FACTOR 0.25
 #define LOW_POWER_SLEEP 900
 #define MQTT_RETRIES 5
 #define MAX_MQTT_RETRIES 15
 #define MAX_SLEEP_TIME 3600
 #define LITTLE_ANSWER_MAX_SIZE 1024
+#define MQTT_PUBLISH_OVERHEAD 7
+#define MQTT_SEQUENCE_OVERHEAD 16
+#define ACK_WINDOW_MAX 8
+#define MQTTS_DER_PATH "/mqtts.der"
+#define MQTTS_DER_MAGIC 0x53545451
+
+// a live log sent with a sequence number, kept in RAM until acknowledged
+struct CoolLiveLog {
+  uint8_t *data;
+  size_t size;
+  uint32_t sequence;
+  unsigned long sent;
+};
+
+struct CoolMqttsHeader {
+  uint32_t magic;
+  uint32_t source;
+  uint32_t crc;
+  uint16_t certificateSize;
+  uint16_t privateKeySize;
+};
 
 class CoolBoard {
 
 public:
   void begin();
   bool config();
+  bool restoreConfig(uint32_t hash);
+  uint32_t coldPrepare();
+  void coldBegin(bool restored);
+  void warmBegin();
+  void saveConfig();
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
   bool update(String &answer);
   void loop();
   void connect();
@@ -63,12 +101,23 @@ public:
   unsigned long getLogInterval();
   void printConf();
   void sleep();
-  void handleActuators(JsonObject &root);
-  void readSensors(JsonObject &root);
-  void readBoardData(JsonObject &root);
+  void handleActuators(CoolTelemetry &telemetry);
+  void readSensors(CoolTelemetry &telemetry);
+  void readBoardData(CoolTelemetry &telemetry);
   void sendSavedMessages();
+  void sendAcknowledged(unsigned long start, float factor);
+  bool sendSaved(CoolBacklogCursor &cursor, uint32_t *sequence);
+  bool publishLive(const uint8_t *data, size_t size, bool batch);
+  void ackLive();
+  void settleLive();
+  void saveLog(const uint8_t *data, size_t size);
+  uint32_t nextSequence();
+  float drainFactor();
+  bool drainAllowed(uint32_t messages, uint32_t bytes, unsigned long elapsed,
+                    float factor);
   void sendConfig(const char *path);
   void sendAllConfig();
+  void sendSchema();
   void parseJsonConfig(const char *filePath, JsonObject &send);
   void readPublicIP(JsonObject &reported);
   void clockProblem();
@@ -82,15 +131,30 @@ public:
   void printMqttState(int state);
   void mqttConnect();
   bool mqttPublish(String data, bool mpack = false);
+  bool mqttPublish(const uint8_t *data, size_t size, bool batch = false);
+  bool publishSavedLog(const uint8_t *data, size_t packed,
+                       uint32_t *sequence = NULL);
+  bool publishSavedBlock(const uint8_t *raw, size_t size,
+                         uint32_t *sequence = NULL);
+  bool publishSequenced(const uint8_t *data, size_t size, bool batch,
+                        uint32_t *sequence);
   bool mqttListen();
   void mqttCallback(char *topic, byte *payload, unsigned int length);
-  void mqttsConfig();
-  static int b64decode(String b64Text, uint8_t *output);
-  void mqttsConvert(String cert);
+  void mqttsConfig(bool warm);
+  bool mqttsConvert(const char *path, uint8_t *&der, size_t &size,
+                    uint32_t &source);
+  bool mqttsRecall();
+  void mqttsStore(uint32_t source);
+  uint32_t mqttsChecksum();
+  bool mqttsInstall();
   void updateFirmware(String firmwareVersion, String firmwareUrl, String firmwareUrlFingerprint);
   void tryFirmwareUpdate();
   void mqttLog(String data, bool mpack = false);
-  char *createLog();
+  void mqttLog(const uint8_t *data, size_t size);
+  void mqttBatch(const uint8_t *data, size_t size);
+  bool sendFrame(const uint8_t *data, size_t size, CoolBacklogCursor *cursor,
+                 uint32_t *sequence = NULL);
+  void createLog(CoolTelemetry &telemetry);
 
 private:
   uint8_t mqttRetries = 0;
@@ -103,16 +167,40 @@ private:
   CoolBoardActuator coolBoardActuator;
   PubSubClient *coolPubSubClient = new PubSubClient;
   WiFiClientSecure *wifiClientSecure = new WiFiClientSecure;
+  CoolBatchClient *mqttClient = new CoolBatchClient(*this->wifiClientSecure);
+  uint8_t *certificate = NULL;
+  size_t certificateSize = 0;
+  uint8_t *privateKey = NULL;
+  size_t privateKeySize = 0;
+  bool mqttsInstalled = false;
   bool sleepActive = true;
   bool manual = false;
+  bool batchActive = false;
+  bool binaryTransport = false;
+  bool ackedDelivery = false;
+  uint8_t ackWindow = 4;
+  uint32_t ackTimeout = 5000;
+  uint32_t sequence = 0;
+  uint32_t lastAck = 0;
+  CoolLiveLog live[ACK_WINDOW_MAX];
+  uint8_t liveCount = 0;
   bool connection = false;
   unsigned long logInterval = 3600;
   unsigned long previousLogTime = 0;
+  float batteryVoltage = 0;
+  uint32_t drainMessages = 0;
+  uint32_t drainBytes = 0;
+  uint32_t drainMillis = 0;
+  bool drainAdaptive = true;
   String mqttId = "";
   String mqttServer = "";
   String mqttInTopic = "";
   String mqttOutTopic = "";
+  String mqttAckTopic = "";
   String mqttOutMpackTopic = "";
+  String mqttOutBatchTopic = "";
+  String mqttOutRawTopic = "";
+  String mqttOutRawBatchTopic = "";
   String updateAnswer = "";
 };
 
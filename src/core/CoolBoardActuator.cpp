@@ -38,7 +38,7 @@ bool CoolBoardActuator::getStatus() {
   return digitalRead(ONBOARD_ACTUATOR_PIN);
 }
 
-bool CoolBoardActuator::doAction(JsonObject &root, uint8_t hour,
+bool CoolBoardActuator::doAction(float measurement, uint8_t hour,
                                  uint8_t minute) {
   DEBUG_VAR("Hour value:", hour);
   DEBUG_VAR("Minute value:", minute);
@@ -46,9 +46,9 @@ bool CoolBoardActuator::doAction(JsonObject &root, uint8_t hour,
   if (this->actif == 1) {
     if (this->temporal == 0) {
       if (this->inverted == 0) {
-        this->normalAction(root[this->primaryType].as<float>());
+        this->normalAction(measurement);
       } else if (this->inverted == 1) {
-        this->invertedAction(root[this->primaryType].as<float>());
+        this->invertedAction(measurement);
       }
     } else if (this->temporal == 1) {
       if (this->secondaryType == "hour") {
@@ -87,6 +87,39 @@ bool CoolBoardActuator::config(JsonObject &root) {
   return (true);
 }
 
+void CoolBoardActuator::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->actif);
+  snapshot.put(this->temporal);
+  snapshot.put(this->inverted);
+  snapshot.put(this->primaryType);
+  snapshot.put(this->secondaryType);
+  snapshot.put(this->rangeLow);
+  snapshot.put(this->timeLow);
+  snapshot.put(this->hourLow);
+  snapshot.put(this->minuteLow);
+  snapshot.put(this->rangeHigh);
+  snapshot.put(this->timeHigh);
+  snapshot.put(this->hourHigh);
+  snapshot.put(this->minuteHigh);
+}
+
+bool CoolBoardActuator::restore(CoolSnapshot &snapshot) {
+  snapshot.get(this->actif);
+  snapshot.get(this->temporal);
+  snapshot.get(this->inverted);
+  snapshot.get(this->primaryType);
+  snapshot.get(this->secondaryType);
+  snapshot.get(this->rangeLow);
+  snapshot.get(this->timeLow);
+  snapshot.get(this->hourLow);
+  snapshot.get(this->minuteLow);
+  snapshot.get(this->rangeHigh);
+  snapshot.get(this->timeHigh);
+  snapshot.get(this->hourHigh);
+  snapshot.get(this->minuteHigh);
+  return (snapshot.isValid());
+}
+
 void CoolBoardActuator::printConf() {
   INFO_LOG("Builtin actuator configuration");
   INFO_VAR("  Actif       = ", this->actif);
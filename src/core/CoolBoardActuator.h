@@ -27,6 +27,8 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
+#include "CoolSnapshot.h"
+
 #define ONBOARD_ACTUATOR_PIN 15
 
 class CoolBoardActuator {
@@ -35,7 +37,7 @@ public:
   void begin();
   bool getStatus();
   void write(bool action);
-  bool doAction(JsonObject &data, uint8_t hour, uint8_t minute);
+  bool doAction(float measurement, uint8_t hour, uint8_t minute);
   void normalAction(float measurment);
   void invertedAction(float measurment);
   void temporalActionOff();
@@ -49,6 +51,8 @@ public:
   void hourMinuteAction(uint8_t hour, uint8_t minute);
   void mixedHourMinuteAction(uint8_t hour, uint8_t minute, float measurment);
   bool config(JsonObject &root);
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
   void printConf();
 
   bool state = 0;
@@ -152,6 +152,14 @@ bool CoolBoardLed::config() {
   return (true);
 }
 
+void CoolBoardLed::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->ledActive);
+}
+
+bool CoolBoardLed::restore(CoolSnapshot &snapshot) {
+  return (snapshot.get(this->ledActive));
+}
+
 void CoolBoardLed::printConf() {
   INFO_LOG("LED configuration");
   INFO_VAR("  LED active =", ledActive);
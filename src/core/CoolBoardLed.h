@@ -28,6 +28,8 @@
 
 #include <NeoPixelBus.h>
 
+#include "CoolSnapshot.h"
+
 #define OFF 0, 0, 0
 #define RED 50, 0, 0
 #define BRIGHT_RED 255, 0, 0
@@ -47,6 +49,8 @@ public:
   void begin();
   void write(uint8_t R, uint8_t G, uint8_t B);
   bool config();
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
   void activate();
   void printConf();
   void fade(uint8_t R, uint8_t G, uint8_t B, float T);
@@ -68,52 +68,56 @@ void CoolBoardSensors::begin() {
 
 void CoolBoardSensors::end() { this->lightSensor.DeInit(); }
 
-void CoolBoardSensors::read(JsonObject &root) {
+void CoolBoardSensors::read(CoolTelemetry &telemetry) {
   delay(100);
 
+  if (this->lightDataActive.visible || this->lightDataActive.ir ||
+      this->lightDataActive.uv) {
+    telemetry.beginObject("SI114X_1");
+  }
   if (this->lightDataActive.visible) {
-    root.createNestedObject("SI114X_1");
     if (this->lightSensor.ReadResponseReg() == CoolSI114X_VIS_OVERFLOW) {
-      root["SI114X_1"]["visibleLight"] = RawJson("null");
+      telemetry.addNull("visibleLight");
       // send NOOP command to SI1145 to clear overflow value
       this->lightSensor.WriteParamData(CoolSI114X_COMMAND, CoolSI114X_NOP);
     } else {
-      root["SI114X_1"]["visibleLight"] = this->lightSensor.ReadVisible();
+      telemetry.add("visibleLight", this->lightSensor.ReadVisible());
     }
   }
   if (this->lightDataActive.ir) {
-    if (!root["SI114X_1"].success()) {
-      root.createNestedObject("SI114X_1");
-    }
     if (this->lightSensor.ReadResponseReg() == CoolSI114X_IR_OVERFLOW) {
-      root["SI114X_1"]["infrared"] = RawJson("null");
+      telemetry.addNull("infrared");
       // send NOOP command to SI1145 to clear overflow value
       this->lightSensor.WriteParamData(CoolSI114X_COMMAND, CoolSI114X_NOP);
     } else {
-      root["SI114X_1"]["infrared"] = this->lightSensor.ReadIR();
+      telemetry.add("infrared", this->lightSensor.ReadIR());
     }
   }
 
   if (this->lightDataActive.uv) {
-    if (!root["SI114X_1"].success()) {
-      root.createNestedObject("SI114X_1");
-    }
     if (this->lightSensor.ReadResponseReg() == CoolSI114X_UV_OVERFLOW) {
-      root["SI114X_1"]["ultraviolet"] = RawJson("null");
+      telemetry.addNull("ultraviolet");
       // send NOOP command to SI1145 to clear overflow value
       this->lightSensor.WriteParamData(CoolSI114X_COMMAND, CoolSI114X_NOP);
     } else {
-      root["SI114X_1"]["ultraviolet"] = (float)this->lightSensor.ReadUV() / 100;
+      telemetry.add("ultraviolet", (float)this->lightSensor.ReadUV() / 100);
     }
   }
+  if (this->lightDataActive.visible || this->lightDataActive.ir ||
+      this->lightDataActive.uv) {
+    telemetry.endObject();
+  }
 
+  if (this->airDataActive.temperature || this->airDataActive.pressure ||
+      this->airDataActive.humidity) {
+    telemetry.beginObject("BME280_1");
+  }
   if (this->airDataActive.temperature) {
     // wait for BME280 to finish data conversion (status reg bit3 == 0)
     while ((this->envSensor.readRegister(BME280_STAT_REG) & 0x10) != 0) {
       yield();
     }
-    root.createNestedObject("BME280_1");
-    root["BME280_1"]["temperature"] = this->envSensor.readTempC();
+    telemetry.add("temperature", this->envSensor.readTempC());
   }
 
   if (this->airDataActive.pressure) {
@@ -121,10 +125,7 @@ void CoolBoardSensors::read(JsonObject &root) {
     while ((this->envSensor.readRegister(BME280_STAT_REG) & 0x10) != 0) {
       yield();
     }
-    if (!root["BME280_1"].success()) {
-      root.createNestedObject("BME280_1");
-    }
-    root["BME280_1"]["pressure"] = this->envSensor.readFloatPressure();
+    telemetry.add("pressure", this->envSensor.readFloatPressure());
   }
 
   if (this->airDataActive.humidity) {
@@ -132,22 +133,25 @@ void CoolBoardSensors::read(JsonObject &root) {
     while ((this->envSensor.readRegister(BME280_STAT_REG) & 0x10) != 0) {
       yield();
     }
-    if (!root["BME280_1"].success()) {
-      root.createNestedObject("BME280_1");
-    }
-    root["BME280_1"]["humidity"] = this->envSensor.readFloatHumidity();
+    telemetry.add("humidity", this->envSensor.readFloatHumidity());
+  }
+  if (this->airDataActive.temperature || this->airDataActive.pressure ||
+      this->airDataActive.humidity) {
+    telemetry.endObject();
   }
   if (this->soilMoistureActive) {
-    root.createNestedObject("soilMoisture_1");
-    root["soilMoisture_1"]["soilMoisture"] = this->readSoilMoisture();
+    telemetry.beginObject("soilMoisture_1");
+    telemetry.add("soilMoisture", this->readSoilMoisture());
+    telemetry.endObject();
   }
   if (this->wallMoistureActive) {
-    root.createNestedObject("wallMoisture_1");
-    root["wallMoisture_1"]["wallMoisture"] = this->readWallMoisture();
+    telemetry.beginObject("wallMoisture_1");
+    telemetry.add("wallMoisture", this->readWallMoisture());
+    telemetry.endObject();
   }
-  root.createNestedObject("battery");
-  root["battery"]["voltage"] = this->readVBat();
-  DEBUG_JSON("Builtin sensors data:", root);
+  telemetry.beginObject("battery");
+  telemetry.add("voltage", this->readVBat());
+  telemetry.endObject();
 }
 
 bool CoolBoardSensors::config() {
@@ -202,6 +206,23 @@ bool CoolBoardSensors::config() {
   return (true);
 }
 
+void CoolBoardSensors::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->lightDataActive);
+  snapshot.put(this->airDataActive);
+  snapshot.put(this->vbatActive);
+  snapshot.put(this->soilMoistureActive);
+  snapshot.put(this->wallMoistureActive);
+}
+
+bool CoolBoardSensors::restore(CoolSnapshot &snapshot) {
+  snapshot.get(this->lightDataActive);
+  snapshot.get(this->airDataActive);
+  snapshot.get(this->vbatActive);
+  snapshot.get(this->soilMoistureActive);
+  snapshot.get(this->wallMoistureActive);
+  return (snapshot.isValid());
+}
+
 void CoolBoardSensors::printConf() {
   INFO_LOG("Builtin sensors configuration");
   INFO_VAR("  Air humidity         =", airDataActive.humidity);
@@ -30,6 +30,8 @@
 
 #include "CoolSI114X.h"
 #include "CoolMessagePack.h"
+#include "CoolSnapshot.h"
+#include "CoolTelemetry.h"
 
 #define MOISTURE_SENSOR_PIN 13
 #define ANALOG_MULTIPLEXER_PIN 12
@@ -44,10 +46,12 @@ class CoolBoardSensors {
 public:
   CoolBoardSensors();
   void begin();
-  void read(JsonObject &root);
+  void read(CoolTelemetry &telemetry);
   void allActive();
   void end();
   bool config();
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
   void printConf();
   void setEnvSensorSettings(uint8_t commInterface = I2C_MODE,
                             uint8_t I2CAddress = 0x76, uint8_t runMode = 3,
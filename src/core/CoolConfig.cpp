@@ -25,26 +25,125 @@
 
 #include "CoolConfig.h"
 #include "CoolLog.h"
+#include "CoolSnapshot.h"
+
+uint32_t CoolConfig::heapPeak = 0;
+CoolConfigEntry CoolConfig::cache[CONFIG_CACHE_SIZE] = {};
 
 CoolConfig::CoolConfig(const char *path) : path(path) {};
 
-bool CoolConfig::readFileAsJson() {
+CoolConfig::~CoolConfig() { delete this->buffer; }
+
+void CoolConfig::share(const char *path) {
+  if (CoolConfig::lookup(path) || strlen(path) >= CONFIG_PATH_SIZE) {
+    return;
+  }
+  for (uint8_t i = 0; i < CONFIG_CACHE_SIZE; i++) {
+    if (CoolConfig::cache[i].path[0] == '\0') {
+      strcpy(CoolConfig::cache[i].path, path);
+      return;
+    }
+  }
+}
+
+void CoolConfig::release(const char *path) {
+  CoolConfigEntry *entry = CoolConfig::lookup(path);
+
+  if (entry) {
+    CoolConfig::invalidate(path);
+    entry->path[0] = '\0';
+  }
+}
+
+void CoolConfig::invalidate(const char *path) {
+  CoolConfigEntry *entry = CoolConfig::lookup(path);
+
+  if (entry && entry->buffer) {
+    DEBUG_VAR("Dropping shared configuration:", path);
+    delete entry->buffer;
+    entry->buffer = NULL;
+  }
+}
+
+CoolConfigEntry *CoolConfig::lookup(const char *path) {
+  for (uint8_t i = 0; i < CONFIG_CACHE_SIZE; i++) {
+    if (CoolConfig::cache[i].path[0] != '\0' &&
+        strcmp(CoolConfig::cache[i].path, path) == 0) {
+      return (&CoolConfig::cache[i]);
+    }
+  }
+  return (NULL);
+}
+
+size_t CoolConfig::measure(File &file) {
+  uint8_t chunk[64];
+  size_t containers = 0;
+  size_t values = 0;
+
+  while (file.available()) {
+    size_t read = file.read(chunk, sizeof(chunk));
+    for (size_t i = 0; i < read; i++) {
+      if (chunk[i] == '{' || chunk[i] == '[') {
+        containers++;
+      } else if (chunk[i] == ',') {
+        values++;
+      }
+    }
+  }
+  file.seek(0, SeekSet);
+  // upper bound of the tree: every token is copied with its terminator,
+  // which the text bounds, and every value takes an object node
+  return (containers * JSON_OBJECT_SIZE(0) +
+          (values + containers) * (JSON_OBJECT_SIZE(1) - JSON_OBJECT_SIZE(0)) +
+          file.size());
+}
+
+bool CoolConfig::readFileAsJson(bool writable) {
+  CoolConfigEntry *entry = writable ? NULL : CoolConfig::lookup(this->path);
+
+  if (entry && entry->buffer) {
+    DEBUG_VAR("Reading shared configuration:", this->path);
+    this->json = entry->json;
+    return (true);
+  }
+  if (!entry) {
+    delete this->buffer;
+    this->buffer = NULL;
+  }
+  uint32_t heap = ESP.getFreeHeap();
   File file = SPIFFS.open(this->path, "r");
 
   if (!file) {
     ERROR_VAR("Failed to open file for reading:", path);
     return (false);
   }
-  String data = file.readString();
-  this->json = this->buffer.parse(data);
+  // one block sized for the whole tree: a block the size of the file
+  // overflows and the next one doubles
+  DynamicJsonBuffer *buffer = new DynamicJsonBuffer(CoolConfig::measure(file));
+  if (entry) {
+    entry->buffer = buffer;
+  } else {
+    this->buffer = buffer;
+  }
+  this->json = buffer->parse(file);
+  // nothing is freed while parsing, so the heap is at its lowest here
+  uint32_t lowest = ESP.getFreeHeap();
+  uint32_t peak = heap > lowest ? heap - lowest : 0;
+  file.close();
+  CoolConfig::heapPeak = max(CoolConfig::heapPeak, peak);
+  DEBUG_VAR("Peak heap of configuration file read:", peak);
   if (!this->json.success()) {
-    file.close();
+    if (entry) {
+      CoolConfig::invalidate(this->path);
+    }
     ERROR_VAR("Failed to parse file as JSON:", this->path);
     return (false);
   }
   DEBUG_VAR("Reading configuration file as JSON:", this->path);
   DEBUG_JSON("Configuration JSON:", this->json);
-  file.close();
+  if (entry) {
+    entry->json = this->json;
+  }
   return (true);
 }
 
@@ -53,13 +152,28 @@ JsonObject &CoolConfig::get() { return this->json; }
 void CoolConfig::setConfig(JsonVariant json) { this->json = json; }
 
 bool CoolConfig::writeJsonToFile() {
-  File file = SPIFFS.open(this->path, "w");
+  String temp = String(this->path) + CONFIG_TEMP_SUFFIX;
+  File file = SPIFFS.open(temp, "w");
+
   if (!file) {
-    ERROR_VAR("Failed to open file for writing:", this->path);
+    ERROR_VAR("Failed to open file for writing:", temp);
     return (false);
   }
-  this->json.printTo(file);
+  size_t length = this->json.measureLength();
+  size_t written = this->json.printTo(file);
   file.close();
+  if (written != length) {
+    ERROR_VAR("Failed to write file:", temp);
+    SPIFFS.remove(temp);
+    return (false);
+  }
+  if ((SPIFFS.exists(this->path) && !SPIFFS.remove(this->path)) ||
+      !SPIFFS.rename(temp.c_str(), this->path)) {
+    ERROR_VAR("Failed to replace file:", this->path);
+    return (false);
+  }
+  CoolSnapshot::forget();
+  CoolConfig::invalidate(this->path);
   DEBUG_VAR("Saved JSON config to:", this->path);
   return (true);
 }
\ No newline at end of file
@@ -26,34 +26,60 @@
 
 #include "ArduinoJson.h"
 #include <Arduino.h>
+#include <FS.h>
+
+#define CONFIG_CACHE_SIZE 2
+#define CONFIG_PATH_SIZE 32
+#define CONFIG_TEMP_SUFFIX ".tmp"
+
+struct CoolConfigEntry {
+  char path[CONFIG_PATH_SIZE];
+  DynamicJsonBuffer *buffer;
+  JsonVariant json;
+};
 
 class CoolConfig {
 
 private:
   const char *path;
   JsonVariant json;
-  DynamicJsonBuffer buffer;
+  DynamicJsonBuffer *buffer = NULL;
+  static uint32_t heapPeak;
+  static CoolConfigEntry cache[CONFIG_CACHE_SIZE];
+  static CoolConfigEntry *lookup(const char *path);
+  static size_t measure(File &file);
 
 public:
   CoolConfig(const char *path);
-  bool readFileAsJson();
+  ~CoolConfig();
+  static uint32_t peakHeap() { return (CoolConfig::heapPeak); }
+  static void share(const char *path);
+  static void release(const char *path);
+  static void invalidate(const char *path);
+  bool readFileAsJson(bool writable = false);
   void setConfig(JsonVariant json);
   JsonObject &get();
   bool writeJsonToFile();
+
+  CoolConfig(CoolConfig const &) = delete;
+  void operator=(CoolConfig const &) = delete;
+
+  // defaults are not written back: shared trees must stay as read from
+  // SPIFFS, only writable readers may overwrite
   template <typename T>
   static void set(JsonObject &json, const char *key, T &val, bool overwrite = false) {
-    if (!overwrite && json[key].success()) {
-      val = json[key].as<T>();
-    } else {
+    if (overwrite) {
       json[key] = val;
+    } else if (json[key].success()) {
+      val = json[key].as<T>();
     }
   };
   template <typename T>
   static void setArray(JsonObject &json, const char *key, const uint8_t i, T &val, bool overwrite = false) {
-    if (!overwrite && json[key][i].success()) {
-      val = json[key][i].as<T>();
-    } else {
+    if (overwrite) {
       json[key][i] = val;
+    } else if (json[key][i].success()) {
+      val = json[key][i].as<T>();
     }
   };
 };
@@ -25,10 +25,9 @@
 
 #include "CoolFileSystem.h"
 #include "CoolConfig.h"
+#include "CoolCrc32.h"
 #include "CoolLog.h"
 
-#define JSON_FILE_EXT_SIZE 5
-
 static constexpr ConfigFile CONFIG_FILES[] = {
       {"general", "/general.json"},
       {"sensors", "/sensors.json"},
@@ -50,13 +49,14 @@ bool CoolFileSystem::fileUpdate(JsonObject &updateJson, const char *path) {
   CoolConfig config(path);
 
   DEBUG_VAR("Updating config file:", path);
-  if (!config.readFileAsJson()) {
+  if (!config.readFileAsJson(true)) {
     ERROR_VAR("Failed to read configuration file for updating:", path);
     return (false);
   }
   JsonObject &fileJson = config.get();
-  for (auto kv : updateJson) {
-      fileJson[kv.key] = updateJson[kv.key];
+  if (!CoolFileSystem::merge(fileJson, updateJson)) {
+    DEBUG_VAR("Configuration file already up to date:", path);
+    return (true);
   }
   DEBUG_VAR("Preparing to update config file:", path);
   DEBUG_JSON("With new JSON:", fileJson);
@@ -68,89 +68,68 @@ bool CoolFileSystem::fileUpdate(JsonObject &updateJson, const char *path) {
   return (true);
 }
 
-bool CoolFileSystem::saveLogToFile(const char *data) {
-  String lastName = "0";
-  FSInfo fs_info;
+bool CoolFileSystem::merge(JsonObject &target, JsonObject &patch) {
+  bool changed = false;
 
-  if (SPIFFS.info(fs_info) == true) {
-    DEBUG_LOG("SPIFFS status before saving:");
-    DEBUG_VAR("SPIFFS used bytes", fs_info.usedBytes);
-    DEBUG_VAR("SPIFFS total bytes", fs_info.totalBytes);
-  }
+  for (auto kv : patch) {
+    JsonVariant value = kv.value;
 
-  int nextLog = lastSavedLogNumber();
-  nextLog++;
-  char nextName[32];
-  snprintf(nextName, 32, "/log/%d.json", nextLog);
-
-  DEBUG_VAR("Next saved data file name:", nextName);
-  if (!SPIFFS.exists(nextName)) {
-    File f = SPIFFS.open(nextName, "w");
-    f.print(data);
-    f.close();
-    DEBUG_VAR("Data file saved as:", nextName);
-  } else {
-    DEBUG_VAR("Could not save data file (already exists):", nextName);
-    return false;
-  }
-  if (SPIFFS.info(fs_info) == true) {
-    DEBUG_LOG("SPIFFS status after saving:");
-    DEBUG_VAR("SPIFFS used bytes", fs_info.usedBytes);
-    DEBUG_VAR("SPIFFS total bytes", fs_info.totalBytes);
+    if (value.is<JsonObject>() && target[kv.key].is<JsonObject>()) {
+      JsonObject &nested = target[kv.key];
+      JsonObject &changes = value;
+      changed |= CoolFileSystem::merge(nested, changes);
+    } else if (!target.containsKey(kv.key) ||
+               !CoolFileSystem::equals(target[kv.key], value)) {
+      target[kv.key] = value;
+      changed = true;
+    }
   }
-  return true;
+  return (changed);
 }
 
-bool CoolFileSystem::hasSavedLogs() {
-  Dir dir = SPIFFS.openDir("/log");
-  if (dir.next()) {
-    return true;
-  } else {
-    return false;
-  }
-}
+bool CoolFileSystem::equals(JsonVariant a, JsonVariant b) {
+  String left;
+  String right;
 
-int CoolFileSystem::lastSavedLogNumber() {
-  int next = 0;
-  int temp = 0;
-  Dir dir = SPIFFS.openDir("/log");
-  while (dir.next()) {
-    temp = dir.fileName().substring(JSON_FILE_EXT_SIZE).toInt();
-    DEBUG_VAR("Saved file data name: ", dir.fileName());
-    if (temp >= next) {
-      next = temp;
-    }
-  }
-  return next;
+  a.printTo(left);
+  b.printTo(right);
+  return (left == right);
 }
 
-String CoolFileSystem::getSavedLogAsString(int num) {
-  char path[32];
-  String data;
-  snprintf(path, 32, "/log/%d.json", num);
-  File f = SPIFFS.open(path, "r");
+void CoolFileSystem::recover() {
+  for (uint8_t i = 0; i < CONFIG_FILES_COUNT; ++i) {
+    const char *path = CONFIG_FILES[i].path;
+    String temp = String(path) + CONFIG_TEMP_SUFFIX;
 
-  if (!f) {
-    ERROR_VAR("Failed to data file:", path);
-    return data;
+    if (!SPIFFS.exists(temp)) {
+      continue;
+    }
+    if (SPIFFS.exists(path)) {
+      WARN_VAR("Removing interrupted configuration update:", temp);
+      SPIFFS.remove(temp);
+    } else {
+      WARN_VAR("Completing interrupted configuration update:", path);
+      SPIFFS.rename(temp.c_str(), path);
+    }
   }
-  data = f.readString();
-  DEBUG_VAR("Read data file:", path);
-  DEBUG_VAR("Data file content:", data);
-  f.close();
-  yield();
-  return data;
 }
 
-bool CoolFileSystem::deleteSavedLog(int num) {
-  char logName[32];
-  snprintf(logName, 32, "/log/%d.json", num);
+uint32_t CoolFileSystem::configHash(uint32_t hash) {
+  uint8_t buffer[64];
+
+  for (uint8_t i = 0; i < CONFIG_FILES_COUNT; ++i) {
+    const char *path = CONFIG_FILES[i].path;
 
-  if (SPIFFS.remove(logName)){
-    INFO_VAR("Deleted log file:", logName);
-    return true;
-  } else {
-    ERROR_VAR("Failed to delete log file:", logName);
-    return false;
+    hash = CoolCrc32::update(hash, path, strlen(path) + 1);
+    File file = SPIFFS.open(path, "r");
+    if (!file) {
+      continue;
+    }
+    size_t length;
+    while ((length = file.read(buffer, sizeof(buffer))) > 0) {
+      hash = CoolCrc32::update(hash, buffer, length);
+    }
+    file.close();
   }
-}
\ No newline at end of file
+  return (hash);
+}
@@ -37,11 +37,10 @@ class CoolFileSystem {
 public:
   static void updateConfigFiles(JsonObject &root);
   static bool fileUpdate(JsonObject &updateJson, const char *path);
-  static bool saveLogToFile(const char *data);
-  static bool hasSavedLogs();
-  static int lastSavedLogNumber();
-  static String getSavedLogAsString(int num);
-  static bool deleteSavedLog(int num);
+  static uint32_t configHash(uint32_t hash);
+  static void recover();
+  static bool merge(JsonObject &target, JsonObject &patch);
+  static bool equals(JsonVariant a, JsonVariant b);
 };
 
 #endif
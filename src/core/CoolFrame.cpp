@@ -0,0 +1,130 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include "CoolFrame.h"
+#include "CoolLog.h"
+#include "CoolSchema.h"
+#include "CoolZ85.h"
+
+CoolFrame::CoolFrame(size_t limit, bool armored)
+    : limit(limit), armored(armored) {}
+
+void CoolFrame::begin(const String &macAddress) {
+  this->telemetry.beginObject();
+  this->telemetry.beginObject("header");
+  this->telemetry.add("macAddress", macAddress);
+  this->telemetry.add("fwVersion", COOL_FW_VERSION);
+  if (CoolSchema::getInstance().isActive()) {
+    this->telemetry.add("schema", CoolSchema::getInstance().hash());
+  }
+  this->telemetry.endObject();
+  this->telemetry.beginArray("samples");
+}
+
+bool CoolFrame::add(const uint8_t *sample, size_t size, bool force) {
+  if (!force && this->samples > 0 && !this->fits(size, 1)) {
+    return (false);
+  }
+  this->telemetry.addEncoded(NULL, sample, size);
+  this->samples++;
+  return (!this->telemetry.failed());
+}
+
+bool CoolFrame::fits(size_t size, uint8_t count) const {
+  size_t next = this->telemetry.size() + size + FRAME_TRAILER_SIZE;
+
+  if (this->armored) {
+    next = CoolZ85::encodedSize(next);
+  }
+  return (this->samples + count <= FRAME_MAX_SAMPLES && next <= this->limit);
+}
+
+void CoolFrame::end() {
+  this->telemetry.endArray();
+  this->telemetry.endObject();
+  DEBUG_VAR("Frame samples:", this->samples);
+  DEBUG_VAR("Frame size in mpack:", this->telemetry.size());
+}
+
+bool CoolFrame::stamp(CoolTelemetry &telemetry, const uint8_t *sample,
+                      size_t size) {
+  CoolSchema &schema = CoolSchema::getInstance();
+  uint32_t count;
+  size_t header;
+
+  if (!CoolFrame::isSample(sample, size)) {
+    return (false);
+  }
+  if ((sample[0] & 0xf0) == 0x80) {
+    count = sample[0] & 0x0f;
+    header = 1;
+  } else {
+    count = (sample[1] << 8) | sample[2];
+    header = 3;
+  }
+  // a saved sample may be sent by another firmware or schema than the
+  // one of its frame header: it carries its own at the end of its map
+  CoolMessagePack::writeMapHeader(telemetry,
+                                  count + (schema.isActive() ? 2 : 1));
+  telemetry.write(sample + header, size - header);
+  CoolFrame::writeKey(telemetry, "fwVersion");
+  CoolMessagePack::writeString(telemetry, COOL_FW_VERSION);
+  if (schema.isActive()) {
+    CoolFrame::writeKey(telemetry, "schema");
+    CoolMessagePack::writeInteger(telemetry, schema.hash());
+  }
+  return (!telemetry.failed());
+}
+
+void CoolFrame::writeKey(Print &sink, const char *key) {
+  int id = CoolSchema::getInstance().isActive()
+               ? CoolSchema::getInstance().id(key)
+               : -1;
+
+  if (id >= 0) {
+    CoolMessagePack::writeInteger(sink, (uint8_t)id);
+  } else {
+    CoolMessagePack::writeString(sink, key);
+  }
+}
+
+bool CoolFrame::isSample(const uint8_t *data, size_t size) {
+  size_t key;
+
+  if (size > 0 && (data[0] & 0xf0) == 0x80) {
+    key = 1;
+  } else if (size > 2 && data[0] == 0xde) {
+    key = 3;
+  } else {
+    return (false);
+  }
+  if (key >= size) {
+    return (false);
+  }
+  // full records start with "state", which is schema key 0
+  if (data[key] == 0x00) {
+    return (false);
+  }
+  return (!(size >= key + 6 && data[key] == 0xa5 &&
+            memcmp(data + key + 1, "state", 5) == 0));
+}
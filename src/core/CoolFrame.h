@@ -0,0 +1,64 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLFRAME_H
+#define COOLFRAME_H
+
+#include <Arduino.h>
+
+#include "CoolTelemetry.h"
+
+#define FRAME_MAX_SAMPLES 32
+#define FRAME_TRAILER_SIZE 3
+
+class CoolFrame {
+
+public:
+  CoolFrame(size_t limit, bool armored = true);
+
+  void begin(const String &macAddress);
+  bool add(const uint8_t *sample, size_t size, bool force = false);
+  bool fits(size_t size, uint8_t count) const;
+  void end();
+  uint8_t count() const { return (this->samples); }
+  const uint8_t *data() const { return (this->telemetry.data()); }
+  size_t size() const { return (this->telemetry.size()); }
+  bool failed() const { return (this->telemetry.failed()); }
+
+  static bool isSample(const uint8_t *data, size_t size);
+  static bool stamp(CoolTelemetry &telemetry, const uint8_t *sample,
+                    size_t size);
+
+  CoolFrame(CoolFrame const &) = delete;
+  void operator=(CoolFrame const &) = delete;
+
+private:
+  static void writeKey(Print &sink, const char *key);
+
+  CoolTelemetry telemetry;
+  size_t limit;
+  bool armored;
+  uint8_t samples = 0;
+};
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include "CoolLzss.h"
+
+struct BitWriter {
+  uint8_t *output;
+  size_t capacity;
+  size_t length;
+  uint8_t bits;
+
+  bool write(uint16_t value, uint8_t count) {
+    while (count-- > 0) {
+      if (this->bits == 0) {
+        if (this->length >= this->capacity) {
+          return (false);
+        }
+        this->output[this->length++] = 0;
+      }
+      if (value & (1 << count)) {
+        this->output[this->length - 1] |= 0x80 >> this->bits;
+      }
+      this->bits = (this->bits + 1) & 7;
+    }
+    return (true);
+  }
+};
+
+struct BitReader {
+  const uint8_t *input;
+  size_t size;
+  size_t offset;
+  uint8_t bits;
+
+  bool read(uint16_t &value, uint8_t count) {
+    value = 0;
+    while (count-- > 0) {
+      if (this->offset >= this->size) {
+        return (false);
+      }
+      uint8_t bit = (this->input[this->offset] >> (7 - this->bits)) & 1;
+      value = (value << 1) | bit;
+      if (++this->bits == 8) {
+        this->bits = 0;
+        this->offset++;
+      }
+    }
+    return (true);
+  }
+};
+
+size_t CoolLzss::compress(const uint8_t *input, size_t size, uint8_t *output,
+                          size_t capacity) {
+  BitWriter writer = {output, capacity, 0, 0};
+  size_t position = 0;
+
+  while (position < size) {
+    size_t start =
+        position > LZSS_WINDOW_SIZE ? position - LZSS_WINDOW_SIZE : 0;
+    size_t bestLength = 0;
+    size_t bestDistance = 0;
+
+    for (size_t candidate = position; candidate-- > start;) {
+      size_t length = 0;
+      while (length < LZSS_MAX_MATCH && position + length < size &&
+             input[candidate + length] == input[position + length]) {
+        length++;
+      }
+      if (length > bestLength) {
+        bestLength = length;
+        bestDistance = position - candidate;
+        if (length == LZSS_MAX_MATCH) {
+          break;
+        }
+      }
+    }
+    bool written;
+    if (bestLength >= LZSS_MIN_MATCH) {
+      written = writer.write(0, 1) &&
+                writer.write(bestDistance - 1, LZSS_WINDOW_BITS) &&
+                writer.write(bestLength - LZSS_MIN_MATCH, LZSS_LENGTH_BITS);
+      position += bestLength;
+    } else {
+      written = writer.write(1, 1) && writer.write(input[position], 8);
+      position++;
+    }
+    if (!written) {
+      return (0);
+    }
+  }
+  return (writer.length);
+}
+
+size_t CoolLzss::decompress(const uint8_t *input, size_t size, uint8_t *output,
+                            size_t capacity) {
+  BitReader reader = {input, size, 0, 0};
+  size_t length = 0;
+  uint16_t value;
+
+  while (length < capacity && reader.read(value, 1)) {
+    if (value == 1) {
+      if (!reader.read(value, 8)) {
+        return (0);
+      }
+      output[length++] = value;
+      continue;
+    }
+    uint16_t distance;
+    uint16_t count;
+    if (!reader.read(distance, LZSS_WINDOW_BITS) ||
+        !reader.read(count, LZSS_LENGTH_BITS)) {
+      return (0);
+    }
+    distance++;
+    count += LZSS_MIN_MATCH;
+    if (distance > length || length + count > capacity) {
+      return (0);
+    }
+    for (uint16_t i = 0; i < count; i++, length++) {
+      output[length] = output[length - distance];
+    }
+  }
+  return (length);
+}
@@ -23,52 +23,188 @@
 
 #include "CoolMessagePack.h"
 
-int8_t CoolMessagePack::isNull(JsonObject &json, const char *key) {
-  String data;
-  String realKey = "\"" + String(key) + "\"";
-  char *str;
-
-  json.printTo(data);
-  if (!(str = strstr(data.c_str(), key))) {
-    return (-1);
+size_t CoolMsgpckCounter::write(uint8_t c) {
+  this->count++;
+  return (1);
+}
+
+size_t CoolMsgpckCounter::write(const uint8_t *data, size_t size) {
+  this->count += size;
+  return (size);
+}
+
+void CoolMessagePack::writeNil(Print &sink) { msgpck_write_nil(&sink); }
+
+void CoolMessagePack::writeBool(Print &sink, bool value) {
+  msgpck_write_bool(&sink, value);
+}
+
+void CoolMessagePack::writeFloat(Print &sink, float value) {
+  msgpck_write_float(&sink, value);
+}
+
+void CoolMessagePack::writeString(Print &sink, const char *value) {
+  msgpck_write_string(&sink, const_cast<char *>(value), strlen(value));
+}
+
+void CoolMessagePack::writeMapHeader(Print &sink, uint32_t size) {
+  msgpck_write_map_header(&sink, size);
+}
+
+void CoolMessagePack::writeArrayHeader(Print &sink, uint32_t size) {
+  msgpck_write_array_header(&sink, size);
+}
+
+bool CoolMessagePack::writeJson(Print &sink, JsonObject &json) {
+  if (!json.success()) {
+    return (false);
   }
-  int i = strlen(key) + 1;
-  if (str[i] == ':') {
-    i++;
+  CoolMessagePack::writeMapHeader(sink, json.size());
+  for (auto kv : json) {
+    CoolMessagePack::writeString(sink, kv.key);
+    CoolMessagePack::writeVariant(sink, kv.value);
   }
-  if (str[i] == ' ') {
-    i++;
+  return (true);
+}
+
+void CoolMessagePack::writeJson(Print &sink, JsonArray &json) {
+  CoolMessagePack::writeArrayHeader(sink, json.size());
+  for (auto value : json) {
+    CoolMessagePack::writeVariant(sink, value);
   }
-  if (str[i] == 'n') {
-    return (1);
+}
+
+void CoolMessagePack::writeVariant(Print &sink, JsonVariant value) {
+  if (CoolMessagePack::isNull(value)) {
+    CoolMessagePack::writeNil(sink);
+  } else if (value.is<bool>()) {
+    CoolMessagePack::writeBool(sink, value.as<bool>());
+  } else if (value.is<const char *>()) {
+    CoolMessagePack::writeString(sink, value.as<const char *>());
+  } else if (value.is<JsonArray>()) {
+    CoolMessagePack::writeJson(sink, value.as<JsonArray &>());
+  } else if (value.is<JsonObject>()) {
+    CoolMessagePack::writeJson(sink, value.as<JsonObject &>());
+  } else if (!value.is<signed int>()) {
+    CoolMessagePack::writeFloat(sink, value.as<float>());
+  } else if (value <= 127 && value >= -128) {
+    CoolMessagePack::writeInteger(sink, value.as<int8_t>());
+  } else if (value <= 32767 && value >= -32768) {
+    CoolMessagePack::writeInteger(sink, value.as<int16_t>());
   } else {
-    return (0);
+    CoolMessagePack::writeInteger(sink, value.as<int32_t>());
   }
 }
 
-int8_t CoolMessagePack::isNullA(JsonArray &json, uint8_t index) {
-  String data;
-  uint8_t i = 0;
-  json.printTo(data);
-  const char *str = data.c_str();
-  while (i != index) {
-    *str++;
-    while (*str && *str != ',') {
-      *str++;
+size_t CoolMessagePack::measureJson(JsonObject &json) {
+  CoolMsgpckCounter counter;
+
+  CoolMessagePack::writeJson(counter, json);
+  return (counter.count);
+}
+
+size_t CoolMessagePack::objectSize(const uint8_t *data, size_t size) {
+  size_t offset = 0;
+  size_t pending = 1;
+
+  while (pending > 0) {
+    if (offset >= size) {
+      return (0);
     }
-    i++;
-  }
-  while (*str && (*str == ',' || *str == ' ' || *str == '[')) {
-    *str++;
-  }
-  if (*str) {
-    if (*str == '0' || *str == 'f') {
+    uint8_t type = data[offset++];
+    uint8_t lengthBytes = 0;
+    uint32_t length = 0;
+    uint8_t children = 0;
+
+    pending--;
+    if (type <= 0x7f || type >= 0xe0 || type == 0xc0 || type == 0xc2 ||
+        type == 0xc3) {
+      continue;
+    } else if ((type & 0xf0) == 0x80) {
+      length = type & 0x0f;
+      children = 2;
+    } else if ((type & 0xf0) == 0x90) {
+      length = type & 0x0f;
+      children = 1;
+    } else if ((type & 0xe0) == 0xa0) {
+      length = type & 0x1f;
+    } else {
+      switch (type) {
+      case 0xcc:
+      case 0xd0:
+        length = 1;
+        break;
+      case 0xcd:
+      case 0xd1:
+        length = 2;
+        break;
+      case 0xca:
+      case 0xce:
+      case 0xd2:
+        length = 4;
+        break;
+      case 0xcb:
+      case 0xcf:
+      case 0xd3:
+        length = 8;
+        break;
+      case 0xc4:
+      case 0xd9:
+        lengthBytes = 1;
+        break;
+      case 0xc5:
+      case 0xda:
+        lengthBytes = 2;
+        break;
+      case 0xc6:
+      case 0xdb:
+        lengthBytes = 4;
+        break;
+      case 0xdc:
+        lengthBytes = 2;
+        children = 1;
+        break;
+      case 0xdd:
+        lengthBytes = 4;
+        children = 1;
+        break;
+      case 0xde:
+        lengthBytes = 2;
+        children = 2;
+        break;
+      case 0xdf:
+        lengthBytes = 4;
+        children = 2;
+        break;
+      default:
+        return (0);
+      }
+    }
+    if (offset + lengthBytes > size) {
       return (0);
+    }
+    for (uint8_t i = 0; i < lengthBytes; i++) {
+      length = (length << 8) | data[offset++];
+    }
+    if (children > 0) {
+      if (length > size) {
+        return (0);
+      }
+      pending += length * children;
     } else {
-      return (1);
+      if (length > size - offset) {
+        return (0);
+      }
+      offset += length;
     }
   }
-  return (-1);
+  return (offset);
+}
+
+bool CoolMessagePack::isNull(JsonVariant value) {
+  return (value.as<const char *>() == NULL && !value.is<bool>() &&
+          !value.is<float>() && !value.is<JsonArray>() &&
+          !value.is<JsonObject>());
 }
 
 uint32_t CoolMessagePack::sizeJsonToMsgpck(JsonObject &json) {
@@ -79,23 +215,23 @@ uint32_t CoolMessagePack::sizeJsonToMsgpck(JsonObject &json) {
   DEBUG_JSON("json:", json);
   for (auto kv : json) {
     size += strlen(kv.key);
-    if (!json[kv.key].is<float>() && json[kv.key] == NULL && CoolMessagePack::isNull(json, kv.key)) {
+    if (CoolMessagePack::isNull(kv.value)) {
       size += 1;
-    } else if (json[kv.key].is<bool>()) {
+    } else if (kv.value.is<bool>()) {
       size += 1;
-    } else if (json[kv.key].is<char *>()) {
-      size += strlen(json[kv.key]) + 1;
-    } else if (json[kv.key].is<JsonArray>()) {
-      size += CoolMessagePack::sizeArrayToMsgpck(json[kv.key]);
-    } else if (json[kv.key].is<JsonObject>()) {
-      size += CoolMessagePack::sizeJsonToMsgpck(json[kv.key]);
-    } else if (!json[kv.key].is<signed int>()) {
+    } else if (kv.value.is<char *>()) {
+      size += strlen(kv.value.as<char *>()) + 1;
+    } else if (kv.value.is<JsonArray>()) {
+      size += CoolMessagePack::sizeArrayToMsgpck(kv.value);
+    } else if (kv.value.is<JsonObject>()) {
+      size += CoolMessagePack::sizeJsonToMsgpck(kv.value);
+    } else if (!kv.value.is<signed int>()) {
       size += 5;
-    } else if (json[kv.key] < 128 && json[kv.key] >= -32) {
+    } else if (kv.value < 128 && kv.value >= -32) {
       size += 1;
-    } else if (json[kv.key] <= 255 && json[kv.key] >= -127) {
+    } else if (kv.value <= 255 && kv.value >= -127) {
       size += 2;
-    } else if (json[kv.key] <= 65535 && json[kv.key] >= -32767) {
+    } else if (kv.value <= 65535 && kv.value >= -32767) {
       size += 3;
     } else {
       size += 4;
@@ -107,11 +243,10 @@ uint32_t CoolMessagePack::sizeJsonToMsgpck(JsonObject &json) {
 uint32_t CoolMessagePack::sizeArrayToMsgpck(JsonArray &json) {
   uint32_t size = 1;
 
-  uint8_t i = 0;
   for (auto kv : json) {
-    if (!kv.is<float>() && kv == NULL && CoolMessagePack::isNullA(json, i)) {
+    if (CoolMessagePack::isNull(kv)) {
       size += 1;
-    }else if (kv.is<bool>()) {
+    } else if (kv.is<bool>()) {
       size += 1;
     } else if (kv.is<char *>()) {
       size += strlen(kv) + 1;
@@ -130,7 +265,6 @@ uint32_t CoolMessagePack::sizeArrayToMsgpck(JsonArray &json) {
     } else {
       size += 4;
     }
-    i++;
   }
   return (size);
 }
@@ -141,32 +275,32 @@ bool CoolMessagePack::jsonToMsgpck(PrintAdapter streamer, JsonObject &json) {
   }
   msgpck_write_map_header(&streamer, json.size());
   for (auto kv : json) {
-    CoolMessagePack::is(streamer, json, kv.key);
+    CoolMessagePack::is(streamer, kv.value, kv.key);
   }
   return (true);
 }
 
-void CoolMessagePack::is(PrintAdapter streamer, JsonObject &json,
+void CoolMessagePack::is(PrintAdapter streamer, JsonVariant value,
                          const char *key) {
-  if (!json[key].is<float>() && json[key] == NULL && CoolMessagePack::isNull(json, key)) {
+  if (CoolMessagePack::isNull(value)) {
     CoolMessagePack::msgpckNil(streamer, String(key));
-  } else if (json[key].is<bool>()) {
-    CoolMessagePack::msgpckBool(streamer, json[key], String(key));
-  } else if (json[key].is<char *>()) {
-    CoolMessagePack::msgpckString(streamer, String(json.get<char *>(key)),
+  } else if (value.is<bool>()) {
+    CoolMessagePack::msgpckBool(streamer, value, String(key));
+  } else if (value.is<char *>()) {
+    CoolMessagePack::msgpckString(streamer, String(value.as<char *>()),
                                   String(key));
-  } else if (json[key].is<JsonArray>()) {
-    CoolMessagePack::jsonArrayToMP(streamer, json[key], String(key));
-  } else if (json[key].is<JsonObject>()) {
-    CoolMessagePack::jsonObjectToMP(streamer, json[key], String(key));
-  } else if (!json[key].is<signed int>()) {
-    CoolMessagePack::msgpckFloat(streamer, json[key], String(key));
-  } else if (json[key].is<signed short>() && json[key] < 255 && json[key] > -256) {
-    CoolMessagePack::msgpckInt(streamer, json.get<int8_t>(key), String(key));
-  } else if (json[key].is<signed int>() && json[key] < 32767 && json[key] > -32768) {
-    CoolMessagePack::msgpckInt(streamer, json.get<int16_t>(key), String(key));
+  } else if (value.is<JsonArray>()) {
+    CoolMessagePack::jsonArrayToMP(streamer, value, String(key));
+  } else if (value.is<JsonObject>()) {
+    CoolMessagePack::jsonObjectToMP(streamer, value, String(key));
+  } else if (!value.is<signed int>()) {
+    CoolMessagePack::msgpckFloat(streamer, value, String(key));
+  } else if (value <= 127 && value >= -128) {
+    CoolMessagePack::msgpckInt(streamer, value.as<int8_t>(), String(key));
+  } else if (value <= 32767 && value >= -32768) {
+    CoolMessagePack::msgpckInt(streamer, value.as<int16_t>(), String(key));
   } else {
-    CoolMessagePack::msgpckInt(streamer, json.get<int32_t>(key), String(key));
+    CoolMessagePack::msgpckInt(streamer, value.as<int32_t>(), String(key));
   }
 }
 
@@ -174,38 +308,33 @@ void CoolMessagePack::jsonObjectToMP(PrintAdapter streamer, JsonObject &json,
                                      String key) {
   CoolMessagePack::msgpckMap(streamer, json.size(), key);
   for (auto kv : json) {
-    CoolMessagePack::is(streamer, json, kv.key);
+    CoolMessagePack::is(streamer, kv.value, kv.key);
   }
 }
 
 void CoolMessagePack::jsonArrayToMP(PrintAdapter streamer, JsonArray &json,
                                     String key) {
   CoolMessagePack::msgpckArray(streamer, (uint32_t)json.size(), key);
-  uint8_t i = 0;
   for (auto kv : json) {
-    if (!kv.is<float>() && kv == NULL && CoolMessagePack::isNullA(json, i)) {
+    if (CoolMessagePack::isNull(kv)) {
       CoolMessagePack::msgpckNil(streamer);
     } else if (kv.is<bool>()) {
       CoolMessagePack::msgpckBool(streamer, kv);
     } else if (kv.is<const char *>()) {
-      CoolMessagePack::msgpckString(streamer,
-                                    String(json.get<const char *>(i)));
-    } else if (kv.is<char *>()) {
-      CoolMessagePack::msgpckString(streamer, String(json.get<char *>(i)));
+      CoolMessagePack::msgpckString(streamer, String(kv.as<const char *>()));
     } else if (kv.is<JsonArray>()) {
       CoolMessagePack::jsonArrayToMP(streamer, kv);
     } else if (kv.is<JsonObject>()) {
       CoolMessagePack::jsonObjectToMP(streamer, kv);
     } else if (!kv.is<signed int>()) {
       CoolMessagePack::msgpckFloat(streamer, kv);
-    } else if (kv.is<signed short>() && kv < 255 && kv > -256) {
-      CoolMessagePack::msgpckInt(streamer, json.get<int8_t>(i));
-    } else if (kv.is<signed int>() && kv < 32767 && kv > -32768) {
-      CoolMessagePack::msgpckInt(streamer, json.get<int16_t>(i));
+    } else if (kv <= 127 && kv >= -128) {
+      CoolMessagePack::msgpckInt(streamer, kv.as<int8_t>());
+    } else if (kv <= 32767 && kv >= -32768) {
+      CoolMessagePack::msgpckInt(streamer, kv.as<int16_t>());
     } else {
-      CoolMessagePack::msgpckInt(streamer, json.get<int32_t>(i));
+      CoolMessagePack::msgpckInt(streamer, kv.as<int32_t>());
     }
-    i++;
   }
 }
 
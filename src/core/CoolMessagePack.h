@@ -29,9 +29,48 @@
 #include "PrintEx.h"
 #include "ArduinoJson.h"
 
+#include <type_traits>
+
+template <size_t Size, bool Signed> struct CoolMsgpckInteger;
+template <> struct CoolMsgpckInteger<1, true> { typedef int8_t type; };
+template <> struct CoolMsgpckInteger<2, true> { typedef int16_t type; };
+template <> struct CoolMsgpckInteger<4, true> { typedef int32_t type; };
+template <> struct CoolMsgpckInteger<1, false> { typedef uint8_t type; };
+template <> struct CoolMsgpckInteger<2, false> { typedef uint16_t type; };
+template <> struct CoolMsgpckInteger<4, false> { typedef uint32_t type; };
+
+class CoolMsgpckCounter : public Print {
+
+public:
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *data, size_t size) override;
+
+  size_t count = 0;
+};
+
 class CoolMessagePack {
 
 public:
+  static void writeNil(Print &sink);
+  static void writeBool(Print &sink, bool value);
+  static void writeFloat(Print &sink, float value);
+  static void writeString(Print &sink, const char *value);
+  static void writeMapHeader(Print &sink, uint32_t size);
+  static void writeArrayHeader(Print &sink, uint32_t size);
+  static bool writeJson(Print &sink, JsonObject &json);
+  static void writeJson(Print &sink, JsonArray &json);
+  static void writeVariant(Print &sink, JsonVariant value);
+  static size_t measureJson(JsonObject &json);
+  static size_t objectSize(const uint8_t *data, size_t size);
+
+  template <typename T> static void writeInteger(Print &sink, T value) {
+    static_assert(std::is_integral<T>::value && sizeof(T) <= 4,
+                  "unsupported msgpack integer type");
+    typedef typename CoolMsgpckInteger<sizeof(T),
+                                       std::is_signed<T>::value>::type Integer;
+    msgpck_write_integer(&sink, (Integer)value);
+  }
+
   static void msgpckMap(PrintAdapter streamer, uint32_t data, String str = "");
   static void msgpckArray(PrintAdapter streamer, uint32_t data, String str = "");
   static void msgpckString(PrintAdapter streamer, String data, String str = "");
@@ -45,13 +84,12 @@ public:
   static void msgpckInt(PrintAdapter streamer, uint16_t data, String str = "");
   static void msgpckInt(PrintAdapter streamer, uint32_t data, String str = "");
 
-  static int8_t isNull(JsonObject &json, const char *key);
-  static int8_t isNullA(JsonArray &json, uint8_t index);
+  static bool isNull(JsonVariant value);
   static uint32_t sizeJsonToMsgpck(JsonObject &json);
   static uint32_t sizeArrayToMsgpck(JsonArray &json);
   static uint32_t sizeIs(JsonObject &json, const char *key);
   static bool jsonToMsgpck(PrintAdapter streamer, JsonObject &json);
-  static void is(PrintAdapter streamer, JsonObject &json, const char *key);
+  static void is(PrintAdapter streamer, JsonVariant value, const char *key);
   static void jsonArrayToMP(PrintAdapter streamer, JsonArray &json, String key = "");
   static void jsonObjectToMP(PrintAdapter streamer, JsonObject &json, String key = "");
 };
@@ -0,0 +1,151 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include "CoolProfiler.h"
+#include "CoolConfig.h"
+#include "CoolLog.h"
+#include "CoolRtcMemory.h"
+
+static const char *PHASE_NAMES[PHASE_COUNT] = {
+    "powerCheck", "spiffsMount", "connect",    "timeSync", "createLog",
+    "mqttLog",    "sendSaved",   "mqttListen", "sleep",    "boot"};
+
+// average supply current in mA, radio on unless noted otherwise
+static const float DEFAULT_PHASE_CURRENT[PHASE_COUNT] = {
+    70., 70., 120., 75., 80., 120., 120., 75., 70., 70.};
+
+CoolProfiler &CoolProfiler::getInstance() {
+  static CoolProfiler instance;
+
+  return instance;
+}
+
+CoolProfiler::CoolProfiler() {
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    this->startTime[i] = 0;
+    this->running[i] = false;
+    this->durations[i] = 0;
+    this->current[i] = DEFAULT_PHASE_CURRENT[i];
+  }
+  this->lastWakeValid =
+      CoolRtcMemory::read(RTC_PROFILER_OFFSET, this->lastWake);
+}
+
+void CoolProfiler::config(JsonObject &json) {
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    CoolConfig::set<float>(json, PHASE_NAMES[i], this->current[i]);
+  }
+}
+
+void CoolProfiler::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->current);
+}
+
+bool CoolProfiler::restore(CoolSnapshot &snapshot) {
+  return (snapshot.get(this->current));
+}
+
+void CoolProfiler::printConf() {
+  DEBUG_LOG("Wake cycle current model (mA)");
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    DEBUG_VAR("  Phase   =", PHASE_NAMES[i]);
+    DEBUG_VAR("  Current =", this->current[i]);
+  }
+}
+
+void CoolProfiler::start(CoolPhase phase) {
+  this->startTime[phase] = millis();
+  this->running[phase] = true;
+}
+
+void CoolProfiler::stop(CoolPhase phase) {
+  if (this->running[phase]) {
+    this->durations[phase] += millis() - this->startTime[phase];
+    this->running[phase] = false;
+  }
+}
+
+void CoolProfiler::commit() {
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    this->stop((CoolPhase)i);
+  }
+  this->printSummary();
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    this->lastWake.durations[i] = this->durations[i];
+    this->durations[i] = 0;
+  }
+  this->lastWake.drainedMessages = this->drainedMessages;
+  this->lastWake.drainedBytes = this->drainedBytes;
+  this->drainedMessages = 0;
+  this->drainedBytes = 0;
+  CoolRtcMemory::write(RTC_PROFILER_OFFSET, this->lastWake);
+  this->lastWakeValid = true;
+}
+
+void CoolProfiler::report(CoolTelemetry &telemetry) {
+  if (!this->lastWakeValid) {
+    return;
+  }
+  telemetry.beginObject("wake");
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    telemetry.add(PHASE_NAMES[i], this->lastWake.durations[i]);
+  }
+  telemetry.add("mAh", this->charge(this->lastWake.durations));
+  telemetry.add("drained", this->lastWake.drainedMessages);
+  telemetry.add("drainedBytes", this->lastWake.drainedBytes);
+  if (this->lastWake.durations[PHASE_SEND_SAVED] > 0) {
+    telemetry.add("drainRate",
+                  this->lastWake.drainedBytes * 1000. /
+                      this->lastWake.durations[PHASE_SEND_SAVED]);
+  }
+  telemetry.endObject();
+}
+
+void CoolProfiler::printSummary() {
+  uint32_t total = 0;
+
+  INFO_LOG("Wake cycle profile");
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    INFO_VAR("  Phase         =", PHASE_NAMES[i]);
+    INFO_VAR("  Duration (ms) =", this->durations[i]);
+    total += this->durations[i];
+  }
+  INFO_VAR("  Awake (ms)    =", total);
+  INFO_NBR("  Charge (mAh)  =", this->charge(this->durations), 4);
+  INFO_VAR("  Drained logs  =", this->drainedMessages);
+  INFO_VAR("  Drained bytes =", this->drainedBytes);
+}
+
+float CoolProfiler::charge(const uint32_t durations[]) {
+  float charge = 0;
+
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    charge += durations[i] * this->current[i];
+  }
+  return (charge / MILLIS_PER_HOUR);
+}
+
+void CoolProfiler::drained(uint32_t messages, uint32_t bytes) {
+  this->drainedMessages += messages;
+  this->drainedBytes += bytes;
+}
@@ -0,0 +1,85 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLPROFILER_H
+#define COOLPROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "CoolSnapshot.h"
+#include "CoolTelemetry.h"
+
+#define MILLIS_PER_HOUR 3600000.
+
+enum CoolPhase {
+  PHASE_POWER_CHECK = 0,
+  PHASE_SPIFFS_MOUNT,
+  PHASE_CONNECT,
+  PHASE_TIME_SYNC,
+  PHASE_CREATE_LOG,
+  PHASE_MQTT_LOG,
+  PHASE_SEND_SAVED,
+  PHASE_MQTT_LISTEN,
+  PHASE_SLEEP,
+  PHASE_BOOT,
+  PHASE_COUNT
+};
+
+class CoolProfiler {
+
+public:
+  static CoolProfiler &getInstance();
+  void config(JsonObject &json);
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
+  void printConf();
+  void start(CoolPhase phase);
+  void stop(CoolPhase phase);
+  void commit();
+  void report(CoolTelemetry &telemetry);
+  void printSummary();
+  float charge(const uint32_t durations[]);
+  void drained(uint32_t messages, uint32_t bytes);
+
+  CoolProfiler(CoolProfiler const &) = delete;
+  void operator=(CoolProfiler const &) = delete;
+
+private:
+  CoolProfiler();
+  unsigned long startTime[PHASE_COUNT];
+  bool running[PHASE_COUNT];
+  uint32_t durations[PHASE_COUNT];
+  float current[PHASE_COUNT];
+  uint32_t drainedMessages = 0;
+  uint32_t drainedBytes = 0;
+  struct {
+    uint32_t crc;
+    uint32_t durations[PHASE_COUNT];
+    uint32_t drainedMessages;
+    uint32_t drainedBytes;
+  } lastWake;
+  bool lastWakeValid = false;
+};
+
+#endif
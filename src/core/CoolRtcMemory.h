@@ -0,0 +1,63 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLRTCMEMORY_H
+#define COOLRTCMEMORY_H
+
+#include <Arduino.h>
+
+#include "CoolCrc32.h"
+
+// offsets are in 4-byte blocks, the first 32 blocks are left to eboot/OTA
+#define RTC_PROFILER_OFFSET 32
+#define RTC_SCHEMA_OFFSET 45
+#define RTC_BACKLOG_OFFSET 47
+#define RTC_STAGE_OFFSET 55
+#define RTC_SNAPSHOT_OFFSET 113
+#define RTC_WIFI_OFFSET 115
+
+class CoolRtcMemory {
+
+public:
+  template <typename T> static bool read(uint32_t offset, T &block) {
+    static_assert(sizeof(T) % 4 == 0, "RTC blocks must be 4-byte aligned");
+    if (!ESP.rtcUserMemoryRead(offset, (uint32_t *)&block, sizeof(T))) {
+      return (false);
+    }
+    return (block.crc == CoolRtcMemory::checksum(block));
+  }
+
+  template <typename T> static bool write(uint32_t offset, T &block) {
+    static_assert(sizeof(T) % 4 == 0, "RTC blocks must be 4-byte aligned");
+    block.crc = CoolRtcMemory::checksum(block);
+    return (ESP.rtcUserMemoryWrite(offset, (uint32_t *)&block, sizeof(T)));
+  }
+
+private:
+  template <typename T> static uint32_t checksum(T &block) {
+    return (CoolCrc32::update(0, (uint8_t *)&block + sizeof(block.crc),
+                              sizeof(T) - sizeof(block.crc)));
+  }
+};
+
+#endif
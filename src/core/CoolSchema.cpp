@@ -0,0 +1,231 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include "CoolSchema.h"
+#include "CoolConfig.h"
+#include "CoolCrc32.h"
+#include "CoolLog.h"
+#include "CoolRtcMemory.h"
+
+// IDs are positions in this table: only ever append to it
+static const char *FIXED_KEYS[] = {
+    "state", "reported", "timestamp", "static", "macAddress", "system",
+    "publicIp", "fwVersion", "wifiSignal", "schema", "wake", "powerCheck",
+    "spiffsMount", "connect", "timeSync", "createLog", "mqttLog", "sendSaved",
+    "mqttListen", "sleep", "mAh", "sample", "SI114X_1", "visibleLight",
+    "infrared", "ultraviolet", "BME280_1", "temperature", "pressure",
+    "humidity", "soilMoisture_1", "soilMoisture", "wallMoisture_1",
+    "wallMoisture", "battery", "voltage", "PT1000", "waterTemp", "phProbe",
+    "ph", "adc2", "EC", "actuators", "enabled", "drained", "drainedBytes",
+    "drainRate", "seq", "configPeak", "boot"};
+
+CoolSchema &CoolSchema::getInstance() {
+  static CoolSchema instance;
+
+  return instance;
+}
+
+CoolSchema::CoolSchema() {
+  if (!CoolRtcMemory::read(RTC_SCHEMA_OFFSET, this->lastPublished)) {
+    this->lastPublished.hash = 0;
+  }
+}
+
+void CoolSchema::config(JsonObject &json) {
+  CoolConfig::set<bool>(json, "compactKeys", this->active);
+}
+
+bool CoolSchema::begin() {
+  this->clear();
+  if (!this->active) {
+    return (true);
+  }
+  if (!this->reserve()) {
+    return (false);
+  }
+  for (const char *key : FIXED_KEYS) {
+    this->add(key, false);
+  }
+  this->fixedCount = this->count;
+
+  CoolConfig config("/sensors.json");
+  if (!config.readFileAsJson()) {
+    ERROR_LOG("Failed to read /sensors.json");
+    return (false);
+  }
+  JsonArray &sensors = config.get()["sensors"];
+  for (auto sensor : sensors) {
+    this->add(sensor["key"].as<const char *>(), true);
+    for (auto measure : sensor["measures"].as<JsonArray>()) {
+      this->add(measure.as<const char *>(), true);
+    }
+  }
+  this->digest();
+  return (true);
+}
+
+void CoolSchema::snapshot(CoolSnapshot &snapshot) {
+  uint8_t owned = this->count - this->fixedCount;
+
+  snapshot.put(this->active);
+  snapshot.put(owned);
+  for (uint8_t i = this->fixedCount; i < this->count; i++) {
+    snapshot.put(String(this->tables->keys[i]));
+  }
+}
+
+bool CoolSchema::restore(CoolSnapshot &snapshot) {
+  uint8_t owned;
+
+  this->clear();
+  if (!snapshot.get(this->active) || !snapshot.get(owned)) {
+    return (false);
+  }
+  if (this->active) {
+    if (!this->reserve()) {
+      return (false);
+    }
+    for (const char *key : FIXED_KEYS) {
+      this->add(key, false);
+    }
+  }
+  this->fixedCount = this->count;
+  for (uint8_t i = 0; i < owned; i++) {
+    String key;
+
+    if (!snapshot.get(key)) {
+      return (false);
+    }
+    this->add(key.c_str(), true);
+  }
+  this->digest();
+  return (true);
+}
+
+void CoolSchema::printConf() {
+  INFO_LOG("Telemetry schema");
+  INFO_VAR("  Compact keys  =", this->active);
+  if (this->isActive()) {
+    INFO_VAR("  Keys          =", this->count);
+    INFO_NBR("  Schema hash   =", this->schemaHash, HEX);
+  }
+}
+
+int CoolSchema::id(const char *key) const {
+  if (this->tables == NULL) {
+    return (-1);
+  }
+  uint32_t hash = CoolSchema::hashKey(key);
+
+  for (uint32_t slot = hash;; slot++) {
+    uint8_t entry = this->tables->index[slot % SCHEMA_INDEX_SIZE];
+
+    if (entry == 0) {
+      return (-1);
+    }
+    entry--;
+    if (this->tables->hashes[entry] == hash &&
+        strcmp(this->tables->keys[entry], key) == 0) {
+      return (entry);
+    }
+  }
+}
+
+void CoolSchema::report(CoolTelemetry &telemetry) {
+  telemetry.beginObject("schema");
+  telemetry.add("hash", this->schemaHash);
+  telemetry.beginArray("keys");
+  for (uint8_t i = 0; i < this->count; i++) {
+    telemetry.add(NULL, this->tables->keys[i]);
+  }
+  telemetry.endArray();
+  telemetry.endObject();
+}
+
+bool CoolSchema::shouldPublish() {
+  return (this->isActive() && this->lastPublished.hash != this->schemaHash);
+}
+
+void CoolSchema::published() {
+  this->lastPublished.hash = this->schemaHash;
+  CoolRtcMemory::write(RTC_SCHEMA_OFFSET, this->lastPublished);
+}
+
+void CoolSchema::clear() {
+  for (uint8_t i = this->fixedCount; i < this->count; i++) {
+    free((void *)this->tables->keys[i]);
+  }
+  delete this->tables;
+  this->tables = NULL;
+  this->count = 0;
+  this->fixedCount = 0;
+  this->schemaHash = 0;
+}
+
+bool CoolSchema::reserve() {
+  this->tables = new CoolSchemaTables();
+  if (this->tables == NULL) {
+    ERROR_LOG("Not enough memory for the telemetry schema");
+    return (false);
+  }
+  return (true);
+}
+
+void CoolSchema::digest() {
+  this->schemaHash = 0;
+  for (uint8_t i = 0; i < this->count; i++) {
+    this->schemaHash =
+        CoolCrc32::update(this->schemaHash, this->tables->keys[i],
+                          strlen(this->tables->keys[i]) + 1);
+  }
+}
+
+void CoolSchema::add(const char *key, bool owned) {
+  if (key == NULL || this->tables == NULL || this->id(key) >= 0) {
+    return;
+  }
+  if (this->count >= SCHEMA_MAX_KEYS) {
+    WARN_VAR("Telemetry schema is full, key sent as text:", key);
+    return;
+  }
+  uint32_t hash = CoolSchema::hashKey(key);
+  uint32_t slot = hash;
+
+  while (this->tables->index[slot % SCHEMA_INDEX_SIZE] != 0) {
+    slot++;
+  }
+  this->tables->keys[this->count] = owned ? strdup(key) : key;
+  this->tables->hashes[this->count] = hash;
+  this->count++;
+  this->tables->index[slot % SCHEMA_INDEX_SIZE] = this->count;
+}
+
+uint32_t CoolSchema::hashKey(const char *key) {
+  uint32_t hash = 2166136261;
+
+  while (*key) {
+    hash ^= (uint8_t)*key++;
+    hash *= 16777619;
+  }
+  return (hash);
+}
@@ -0,0 +1,81 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLSCHEMA_H
+#define COOLSCHEMA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include "CoolSnapshot.h"
+#include "CoolTelemetry.h"
+
+#define SCHEMA_MAX_KEYS 128
+#define SCHEMA_INDEX_SIZE 256
+
+// allocated only while compact keys are active
+struct CoolSchemaTables {
+  const char *keys[SCHEMA_MAX_KEYS];
+  uint32_t hashes[SCHEMA_MAX_KEYS];
+  // open addressing on the key hash, holds key ID + 1 and 0 when empty
+  uint8_t index[SCHEMA_INDEX_SIZE];
+};
+
+class CoolSchema {
+
+public:
+  static CoolSchema &getInstance();
+  void config(JsonObject &json);
+  bool begin();
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
+  void printConf();
+  bool isActive() const { return (this->active && this->count > 0); }
+  int id(const char *key) const;
+  uint32_t hash() const { return (this->schemaHash); }
+  void report(CoolTelemetry &telemetry);
+  bool shouldPublish();
+  void published();
+
+  CoolSchema(CoolSchema const &) = delete;
+  void operator=(CoolSchema const &) = delete;
+
+private:
+  CoolSchema();
+  void clear();
+  bool reserve();
+  void add(const char *key, bool owned);
+  void digest();
+  static uint32_t hashKey(const char *key);
+  CoolSchemaTables *tables = NULL;
+  uint8_t count = 0;
+  uint8_t fixedCount = 0;
+  uint32_t schemaHash = 0;
+  bool active = false;
+  struct {
+    uint32_t crc;
+    uint32_t hash;
+  } lastPublished;
+};
+
+#endif
@@ -0,0 +1,164 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include <FS.h>
+
+#include "CoolCrc32.h"
+#include "CoolFileSystem.h"
+#include "CoolLog.h"
+#include "CoolRtcMemory.h"
+#include "CoolSnapshot.h"
+
+CoolSnapshot::CoolSnapshot() {
+  this->data = (uint8_t *)malloc(SNAPSHOT_MAX_SIZE);
+}
+
+CoolSnapshot::~CoolSnapshot() { free(this->data); }
+
+uint32_t CoolSnapshot::hash() {
+  const uint16_t version = SNAPSHOT_VERSION;
+  uint32_t hash = CoolCrc32::update(0, &version, sizeof(version));
+
+  hash = CoolCrc32::update(hash, COOL_FW_VERSION, strlen(COOL_FW_VERSION));
+  return (CoolFileSystem::configHash(hash));
+}
+
+bool CoolSnapshot::recall(uint32_t &hash) {
+  CoolSnapshotState state;
+
+  if (!CoolRtcMemory::read(RTC_SNAPSHOT_OFFSET, state) || state.hash == 0) {
+    return (false);
+  }
+  hash = state.hash;
+  return (true);
+}
+
+void CoolSnapshot::remember(uint32_t hash) {
+  CoolSnapshotState state;
+
+  state.hash = hash;
+  CoolRtcMemory::write(RTC_SNAPSHOT_OFFSET, state);
+}
+
+void CoolSnapshot::forget() { CoolSnapshot::remember(0); }
+
+bool CoolSnapshot::load(uint32_t hash) {
+  CoolSnapshotHeader header;
+
+  if (!this->data) {
+    return (false);
+  }
+  File file = SPIFFS.open(SNAPSHOT_PATH, "r");
+  if (!file) {
+    DEBUG_LOG("No configuration snapshot");
+    return (false);
+  }
+  bool valid = file.read((uint8_t *)&header, sizeof(header)) ==
+                   sizeof(header) &&
+               header.magic == SNAPSHOT_MAGIC &&
+               header.version == SNAPSHOT_VERSION && header.hash == hash &&
+               header.size <= SNAPSHOT_MAX_SIZE &&
+               file.read(this->data, header.size) == header.size &&
+               CoolCrc32::update(0, this->data, header.size) == header.crc;
+  file.close();
+  if (!valid) {
+    INFO_LOG("Configuration snapshot is outdated");
+    return (false);
+  }
+  this->size = header.size;
+  this->position = 0;
+  this->overflow = false;
+  DEBUG_VAR("Loaded configuration snapshot, bytes:", this->size);
+  return (true);
+}
+
+bool CoolSnapshot::save(uint32_t hash) {
+  CoolSnapshotHeader header;
+
+  if (!this->isValid()) {
+    WARN_LOG("Configuration snapshot is incomplete, not saved");
+    return (false);
+  }
+  header.magic = SNAPSHOT_MAGIC;
+  header.version = SNAPSHOT_VERSION;
+  header.size = this->position;
+  header.hash = hash;
+  header.crc = CoolCrc32::update(0, this->data, this->position);
+  File file = SPIFFS.open(SNAPSHOT_PATH, "w");
+  if (!file) {
+    ERROR_VAR("Failed to open file for writing:", SNAPSHOT_PATH);
+    return (false);
+  }
+  bool written =
+      file.write((uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+      file.write(this->data, this->position) == this->position;
+  file.close();
+  if (!written) {
+    ERROR_VAR("Failed to write file:", SNAPSHOT_PATH);
+    SPIFFS.remove(SNAPSHOT_PATH);
+    return (false);
+  }
+  DEBUG_VAR("Saved configuration snapshot, bytes:", this->position);
+  return (true);
+}
+
+bool CoolSnapshot::write(const void *data, size_t size) {
+  if (!this->data || this->position + size > SNAPSHOT_MAX_SIZE) {
+    this->overflow = true;
+    return (false);
+  }
+  memcpy(this->data + this->position, data, size);
+  this->position += size;
+  return (true);
+}
+
+bool CoolSnapshot::read(void *data, size_t size) {
+  if (this->overflow || this->position + size > this->size) {
+    this->overflow = true;
+    return (false);
+  }
+  memcpy(data, this->data + this->position, size);
+  this->position += size;
+  return (true);
+}
+
+bool CoolSnapshot::put(const String &val) {
+  uint16_t length = val.length();
+
+  return (this->put(length) && this->write(val.c_str(), length));
+}
+
+bool CoolSnapshot::get(String &val) {
+  uint16_t length;
+
+  if (!this->get(length) || this->position + length > this->size) {
+    this->overflow = true;
+    return (false);
+  }
+  val = "";
+  val.reserve(length);
+  for (uint16_t i = 0; i < length; i++) {
+    val += (char)this->data[this->position++];
+  }
+  return (true);
+}
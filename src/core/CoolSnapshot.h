@@ -0,0 +1,81 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLSNAPSHOT_H
+#define COOLSNAPSHOT_H
+
+#include <Arduino.h>
+
+#define SNAPSHOT_PATH "/config.bin"
+#define SNAPSHOT_MAGIC 0x50414e53
+#define SNAPSHOT_VERSION 2
+#define SNAPSHOT_MAX_SIZE 2048
+
+struct CoolSnapshotState {
+  uint32_t crc;
+  uint32_t hash;
+};
+
+struct CoolSnapshotHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  uint32_t hash;
+  uint32_t crc;
+};
+
+class CoolSnapshot {
+
+public:
+  CoolSnapshot();
+  ~CoolSnapshot();
+  bool load(uint32_t hash);
+  bool save(uint32_t hash);
+  static uint32_t hash();
+  static bool recall(uint32_t &hash);
+  static void remember(uint32_t hash);
+  static void forget();
+  bool write(const void *data, size_t size);
+  bool read(void *data, size_t size);
+  template <typename T> bool put(const T &val) {
+    return (this->write(&val, sizeof(T)));
+  }
+  template <typename T> bool get(T &val) {
+    return (this->read(&val, sizeof(T)));
+  }
+  bool put(const String &val);
+  bool get(String &val);
+  void discard() { this->overflow = true; }
+  bool isValid() const { return (this->data != NULL && !this->overflow); }
+
+  CoolSnapshot(CoolSnapshot const &) = delete;
+  void operator=(CoolSnapshot const &) = delete;
+
+private:
+  uint8_t *data = NULL;
+  size_t size = 0;
+  size_t position = 0;
+  bool overflow = false;
+};
+
+#endif
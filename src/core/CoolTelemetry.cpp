@@ -0,0 +1,197 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include "CoolTelemetry.h"
+#include "CoolLog.h"
+#include "CoolSchema.h"
+
+CoolTelemetry::CoolTelemetry() { this->reserve(TELEMETRY_INITIAL_CAPACITY); }
+
+CoolTelemetry::~CoolTelemetry() { free(this->buffer); }
+
+size_t CoolTelemetry::write(uint8_t c) { return (this->write(&c, 1)); }
+
+size_t CoolTelemetry::write(const uint8_t *data, size_t size) {
+  if (!this->reserve(size)) {
+    return (0);
+  }
+  memcpy(this->buffer + this->length, data, size);
+  this->length += size;
+  return (size);
+}
+
+void CoolTelemetry::beginObject(const char *key) { this->begin(key, true); }
+
+void CoolTelemetry::endObject() { this->end(true); }
+
+void CoolTelemetry::beginArray(const char *key) { this->begin(key, false); }
+
+void CoolTelemetry::endArray() { this->end(false); }
+
+void CoolTelemetry::add(const char *key, float value) {
+  this->addKey(key);
+  CoolMessagePack::writeFloat(*this, value);
+}
+
+void CoolTelemetry::add(const char *key, double value) {
+  this->add(key, (float)value);
+}
+
+void CoolTelemetry::add(const char *key, bool value) {
+  this->addKey(key);
+  CoolMessagePack::writeBool(*this, value);
+}
+
+void CoolTelemetry::add(const char *key, const char *value) {
+  this->addKey(key);
+  CoolMessagePack::writeString(*this, value);
+}
+
+void CoolTelemetry::add(const char *key, const String &value) {
+  this->add(key, value.c_str());
+}
+
+void CoolTelemetry::addNull(const char *key) {
+  this->addKey(key);
+  CoolMessagePack::writeNil(*this);
+}
+
+void CoolTelemetry::addEncoded(const char *key, const uint8_t *data,
+                               size_t size) {
+  this->addKey(key);
+  this->write(data, size);
+}
+
+void CoolTelemetry::begin(const char *key, bool object) {
+  if (this->depth >= TELEMETRY_MAX_DEPTH) {
+    ERROR_LOG("Telemetry nesting is too deep");
+    this->overflow = true;
+    return;
+  }
+  this->addKey(key);
+  this->stack[this->depth].offset = this->length;
+  this->stack[this->depth].count = 0;
+  this->stack[this->depth].object = object;
+  this->depth++;
+  this->write(object ? 0x80 : 0x90);
+}
+
+void CoolTelemetry::end(bool object) {
+  if (this->depth == 0 || this->stack[this->depth - 1].object != object) {
+    ERROR_LOG("Unbalanced telemetry container");
+    this->overflow = true;
+    return;
+  }
+  this->depth--;
+  Container &container = this->stack[this->depth];
+  if (this->overflow) {
+    return;
+  }
+  if (container.count < 16) {
+    this->buffer[container.offset] |= container.count;
+    return;
+  }
+  if (!this->reserve(2)) {
+    return;
+  }
+  uint8_t *header = this->buffer + container.offset;
+  memmove(header + 3, header + 1, this->length - container.offset - 1);
+  this->length += 2;
+  header[0] = object ? 0xde : 0xdc;
+  header[1] = container.count >> 8;
+  header[2] = container.count & 0xff;
+}
+
+void CoolTelemetry::addKey(const char *key) {
+  if (this->depth == 0) {
+    return;
+  }
+  Container &container = this->stack[this->depth - 1];
+  container.count++;
+  if (!container.object) {
+    return;
+  }
+  size_t offset = this->length;
+  int id = this->schema ? this->schema->id(key) : -1;
+  if (id >= 0) {
+    CoolMessagePack::writeInteger(*this, (uint8_t)id);
+  } else {
+    CoolMessagePack::writeString(*this, key);
+  }
+  this->replaceKey(offset);
+}
+
+void CoolTelemetry::replaceKey(size_t key) {
+  // a JsonObject overwrote repeated keys, e.g. external sensors that write
+  // flat into "sample": drop the earlier entry so the last value wins
+  Container &container = this->stack[this->depth - 1];
+  size_t size = this->length - key;
+  size_t offset = container.offset + 1;
+
+  if (this->overflow) {
+    return;
+  }
+  while (offset < key) {
+    size_t keySize = CoolMessagePack::objectSize(this->buffer + offset,
+                                                 key - offset);
+    size_t valueSize = CoolMessagePack::objectSize(
+        this->buffer + offset + keySize, key - offset - keySize);
+
+    if (keySize == 0 || valueSize == 0) {
+      return;
+    }
+    if (keySize == size && memcmp(this->buffer + offset, this->buffer + key,
+                                  size) == 0) {
+      size_t entry = keySize + valueSize;
+
+      memmove(this->buffer + offset, this->buffer + offset + entry,
+              this->length - offset - entry);
+      this->length -= entry;
+      container.count--;
+      return;
+    }
+    offset += keySize + valueSize;
+  }
+}
+
+bool CoolTelemetry::reserve(size_t size) {
+  if (this->overflow) {
+    return (false);
+  }
+  if (this->length + size <= this->capacity) {
+    return (true);
+  }
+  size_t capacity = this->capacity ? this->capacity : size;
+  while (capacity < this->length + size) {
+    capacity *= 2;
+  }
+  uint8_t *buffer = (uint8_t *)realloc(this->buffer, capacity);
+  if (!buffer) {
+    ERROR_VAR("Failed to grow telemetry buffer to:", capacity);
+    this->overflow = true;
+    return (false);
+  }
+  this->buffer = buffer;
+  this->capacity = capacity;
+  return (true);
+}
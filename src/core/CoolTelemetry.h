@@ -0,0 +1,94 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLTELEMETRY_H
+#define COOLTELEMETRY_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+#include "CoolMessagePack.h"
+
+#define TELEMETRY_INITIAL_CAPACITY 256
+#define TELEMETRY_MAX_DEPTH 8
+
+class CoolSchema;
+
+class CoolTelemetry : public Print {
+
+public:
+  CoolTelemetry();
+  ~CoolTelemetry();
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *data, size_t size) override;
+
+  void beginObject(const char *key = NULL);
+  void endObject();
+  void beginArray(const char *key = NULL);
+  void endArray();
+  void add(const char *key, float value);
+  void add(const char *key, double value);
+  void add(const char *key, bool value);
+  void add(const char *key, const char *value);
+  void add(const char *key, const String &value);
+  void addNull(const char *key);
+  void addEncoded(const char *key, const uint8_t *data, size_t size);
+
+  template <typename T> void add(const char *key, T value) {
+    static_assert(std::is_integral<T>::value, "unsupported telemetry type");
+    this->addKey(key);
+    CoolMessagePack::writeInteger(*this, value);
+  }
+
+  void setSchema(const CoolSchema *schema) { this->schema = schema; }
+  const uint8_t *data() const { return (this->buffer); }
+  size_t size() const { return (this->length); }
+  bool failed() const { return (this->overflow); }
+
+  CoolTelemetry(CoolTelemetry const &) = delete;
+  void operator=(CoolTelemetry const &) = delete;
+
+private:
+  struct Container {
+    size_t offset;
+    uint16_t count;
+    bool object;
+  };
+
+  void begin(const char *key, bool object);
+  void end(bool object);
+  void addKey(const char *key);
+  void replaceKey(size_t key);
+  bool reserve(size_t size);
+
+  const CoolSchema *schema = NULL;
+  uint8_t *buffer = NULL;
+  size_t length = 0;
+  size_t capacity = 0;
+  bool overflow = false;
+  Container stack[TELEMETRY_MAX_DEPTH];
+  uint8_t depth = 0;
+};
+
+#endif
@@ -27,28 +27,103 @@
 
 #include "CoolConfig.h"
 #include "CoolLog.h"
+#include "CoolRtcMemory.h"
 #include "CoolWifi.h"
 #include "WiFiManagerReadFileButton.h"
 #include <ESP8266HTTPClient.h>
 
-#define MAX_WIFI_NETWORKS 10
+extern "C" {
+#include "user_interface.h"
+}
+
 #define WIFI_CONNECT_TIMEOUT_DECISECONDS 300
+#define WIFI_FAST_CONNECT_TIMEOUT_DECISECONDS 50
 
 void CoolWifi::connect() {
-  this->config();
   INFO_LOG("Wifi connecting...");
   int i = 0;
   DEBUG_VAR("Entry time to Wifi connection attempt:", millis());
-  while ((this->wifiMulti.run() != WL_CONNECTED) &&
-         (i < WIFI_CONNECT_TIMEOUT_DECISECONDS)) {
-    i++;
-    delay(100);
+  WiFi.persistent(false);
+  if (!this->fastConnect()) {
+    while ((this->wifiMulti.run() != WL_CONNECTED) &&
+           (i < WIFI_CONNECT_TIMEOUT_DECISECONDS)) {
+      i++;
+      delay(100);
+    }
   }
   DEBUG_VAR("Exit time from Wifi connection attempt:", millis());
-
+  if (WiFi.status() == WL_CONNECTED) {
+    this->remember();
+  }
   printStatus(WiFi.status());
 }
 
+bool CoolWifi::fastConnect() {
+  CoolWifiCache cache;
+
+  if (!CoolRtcMemory::read(RTC_WIFI_OFFSET, cache) ||
+      cache.network >= this->wifiCount ||
+      cache.ssid != CoolCrc32::update(0, this->ssidList[cache.network].c_str(),
+                                      this->ssidList[cache.network].length())) {
+    return (false);
+  }
+  INFO_VAR("Reconnecting to last Wifi network:",
+           this->ssidList[cache.network]);
+  if (this->reuseIp && cache.ip != 0) {
+    WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway),
+                IPAddress(cache.subnet), IPAddress(cache.dns));
+  }
+  WiFi.begin(this->ssidList[cache.network].c_str(),
+             this->passList[cache.network].c_str(), cache.channel,
+             cache.bssid);
+  for (int i = 0; i < WIFI_FAST_CONNECT_TIMEOUT_DECISECONDS; i++) {
+    wl_status_t status = WiFi.status();
+    if (status == WL_CONNECTED) {
+      return (true);
+    }
+    if (status == WL_CONNECT_FAILED || status == WL_NO_SSID_AVAIL) {
+      break;
+    }
+    delay(100);
+  }
+  WARN_LOG("Fast reconnect failed, scanning for Wifi networks");
+  CoolWifi::forget();
+  WiFi.disconnect();
+  if (this->reuseIp && cache.ip != 0) {
+    wifi_station_dhcpc_start();
+  }
+  return (false);
+}
+
+void CoolWifi::remember() {
+  CoolWifiCache cache;
+  String ssid = WiFi.SSID();
+
+  cache.network = 0xff;
+  for (uint8_t i = 0; i < this->wifiCount; i++) {
+    if (this->ssidList[i] == ssid) {
+      cache.network = i;
+      break;
+    }
+  }
+  cache.ssid = CoolCrc32::update(0, ssid.c_str(), ssid.length());
+  cache.channel = WiFi.channel();
+  memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+  cache.ip = WiFi.localIP();
+  cache.gateway = WiFi.gatewayIP();
+  cache.subnet = WiFi.subnetMask();
+  cache.dns = WiFi.dnsIP();
+  CoolRtcMemory::write(RTC_WIFI_OFFSET, cache);
+}
+
+void CoolWifi::forget() {
+  CoolWifiCache cache;
+
+  memset(&cache, 0, sizeof(cache));
+  cache.network = 0xff;
+  CoolRtcMemory::write(RTC_WIFI_OFFSET, cache);
+}
+
 void CoolWifi::printStatus(wl_status_t status) {
   switch (status) {
   case WL_NO_SHIELD:
@@ -137,20 +212,44 @@ bool CoolWifi::config() {
   JsonObject &json = config.get();
   config.set<uint8_t>(json, "wifiCount", this->wifiCount);
   config.set<uint8_t>(json, "timeOut", this->timeOut);
+  config.set<bool>(json, "reuseIp", this->reuseIp);
+  this->wifiCount = min(this->wifiCount, (uint8_t)MAX_WIFI_NETWORKS);
 
-  String ssidList[this->wifiCount];
-  String passList[this->wifiCount];
   for (int i = 0; i < this->wifiCount; i++) {
     String key = "Wifi" + String(i);
-    if (!json[key].success()) {
-      json.createNestedObject(key);
-    }
-    config.set<String>(json[key], "ssid", ssidList[i]);
-    config.set<String>(json[key], "pass", passList[i]);
-    this->wifiMulti.addAP(ssidList[i].c_str(), passList[i].c_str());
+    config.set<String>(json[key], "ssid", this->ssidList[i]);
+    config.set<String>(json[key], "pass", this->passList[i]);
+    this->wifiMulti.addAP(this->ssidList[i].c_str(),
+                          this->passList[i].c_str());
   }
   INFO_LOG("Wifi configuration loaded");
-  this->printConf(ssidList);
+  this->printConf(this->ssidList);
+  return (true);
+}
+
+void CoolWifi::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->wifiCount);
+  snapshot.put(this->timeOut);
+  snapshot.put(this->reuseIp);
+  for (int i = 0; i < this->wifiCount; i++) {
+    snapshot.put(this->ssidList[i]);
+    snapshot.put(this->passList[i]);
+  }
+}
+
+bool CoolWifi::restore(CoolSnapshot &snapshot) {
+  if (!snapshot.get(this->wifiCount) || !snapshot.get(this->timeOut) ||
+      !snapshot.get(this->reuseIp) || this->wifiCount > MAX_WIFI_NETWORKS) {
+    return (false);
+  }
+  for (int i = 0; i < this->wifiCount; i++) {
+    if (!snapshot.get(this->ssidList[i]) || !snapshot.get(this->passList[i])) {
+      return (false);
+    }
+    this->wifiMulti.addAP(this->ssidList[i].c_str(),
+                          this->passList[i].c_str());
+  }
+  this->printConf(this->ssidList);
   return (true);
 }
 
@@ -163,7 +262,7 @@ bool CoolWifi::addWifi(String ssid, String pass) {
               "networks");
     return (false);
   }
-  if (!config.readFileAsJson()) {
+  if (!config.readFileAsJson(true)) {
     ERROR_LOG("Cannot add new network, failed to read Wifi configuration");
     return (false);
   }
@@ -178,6 +277,9 @@ bool CoolWifi::addWifi(String ssid, String pass) {
     ERROR_LOG("Cannot add new network, failed to save Wifi configuration");
     return (false);
   }
+  this->ssidList[this->wifiCount] = ssid;
+  this->passList[this->wifiCount] = pass;
+  this->wifiMulti.addAP(ssid.c_str(), pass.c_str());
   ++this->wifiCount;
   INFO_VAR("Added new network to Wifi configuration:",
            String(F("SSID:")) + ssid + String(F("PSK:")) + pass);
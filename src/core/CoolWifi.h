@@ -27,6 +27,21 @@
 #include <Arduino.h>
 #include <ESP8266WiFiMulti.h>
 #include "CoolBoardLed.h"
+#include "CoolSnapshot.h"
+
+#define MAX_WIFI_NETWORKS 10
+
+struct CoolWifiCache {
+  uint32_t crc;
+  uint32_t ssid;
+  uint32_t ip;
+  uint32_t gateway;
+  uint32_t subnet;
+  uint32_t dns;
+  uint8_t bssid[6];
+  uint8_t channel;
+  uint8_t network;
+};
 
 class CoolWifi {
 
@@ -34,6 +49,8 @@ public:
   ESP8266WiFiMulti wifiMulti;
   static void printStatus(wl_status_t status);
   bool config();
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
   bool createSimpleWifiJson();
   void connect();
   void startAccessPoint(CoolBoardLed &led);
@@ -42,7 +59,13 @@ public:
 private:
   bool addWifi(String ssid, String pass);
   void printConf(String ssid[]);
+  bool fastConnect();
+  void remember();
+  static void forget();
   uint8_t timeOut = 180;
+  bool reuseIp = false;
+  String ssidList[MAX_WIFI_NETWORKS];
+  String passList[MAX_WIFI_NETWORKS];
 };
 
 #endif
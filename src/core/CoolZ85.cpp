@@ -0,0 +1,93 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include "CoolZ85.h"
+#include "z85.h"
+
+CoolZ85::CoolZ85(Print &out, bool quoted) : out(out), quoted(quoted) {}
+
+size_t CoolZ85::write(uint8_t c) { return (this->write(&c, 1)); }
+
+size_t CoolZ85::write(const uint8_t *data, size_t size) {
+  if (!this->started) {
+    this->started = true;
+    if (this->quoted) {
+      this->chunk[this->chunkLength++] = '"';
+    }
+  }
+  for (size_t i = 0; i < size; i++) {
+    this->group[this->groupLength++] = data[i];
+    if (this->groupLength == Z85_GROUP_SIZE) {
+      this->encodeGroup();
+    }
+  }
+  return (size);
+}
+
+size_t CoolZ85::end() {
+  if (!this->started) {
+    this->write(NULL, 0);
+  }
+  if (this->groupLength > 0) {
+    memset(this->group + this->groupLength, 0,
+           Z85_GROUP_SIZE - this->groupLength);
+    this->encodeGroup();
+  }
+  if (this->quoted) {
+    if (this->chunkLength == sizeof(this->chunk)) {
+      this->flush();
+    }
+    this->chunk[this->chunkLength++] = '"';
+  }
+  this->flush();
+  return (this->written);
+}
+
+size_t CoolZ85::encodedSize(size_t size, bool quoted) {
+  return ((size + Z85_GROUP_SIZE - 1) / Z85_GROUP_SIZE * Z85_SYMBOL_SIZE +
+          (quoted ? 2 : 0));
+}
+
+void CoolZ85::encodeGroup() {
+  if (this->chunkLength + Z85_SYMBOL_SIZE > sizeof(this->chunk)) {
+    this->flush();
+  }
+  Z85_encode_unsafe((const char *)this->group,
+                    (const char *)this->group + Z85_GROUP_SIZE,
+                    this->chunk + this->chunkLength);
+  this->chunkLength += Z85_SYMBOL_SIZE;
+  this->groupLength = 0;
+}
+
+void CoolZ85::flush() {
+  if (this->chunkLength == 0) {
+    return;
+  }
+  size_t written = this->out.write((const uint8_t *)this->chunk,
+                                   this->chunkLength);
+  if (written != this->chunkLength) {
+    this->overflow = true;
+  }
+  this->written += written;
+  this->chunkLength = 0;
+}
@@ -0,0 +1,60 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef COOLZ85_H
+#define COOLZ85_H
+
+#include <Arduino.h>
+
+#define Z85_GROUP_SIZE 4
+#define Z85_SYMBOL_SIZE 5
+#define Z85_CHUNK_GROUPS 32
+
+class CoolZ85 : public Print {
+
+public:
+  CoolZ85(Print &out, bool quoted = true);
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *data, size_t size) override;
+  size_t end();
+  bool failed() const { return (this->overflow); }
+
+  static size_t encodedSize(size_t size, bool quoted = true);
+
+private:
+  void encodeGroup();
+  void flush();
+
+  Print &out;
+  bool quoted;
+  bool started = false;
+  bool overflow = false;
+  uint8_t group[Z85_GROUP_SIZE];
+  uint8_t groupLength = 0;
+  char chunk[Z85_CHUNK_GROUPS * Z85_SYMBOL_SIZE];
+  size_t chunkLength = 0;
+  size_t written = 0;
+};
+
+#endif
@@ -128,27 +128,29 @@ void ExternalSensors::begin() {
   }
 }
 
-void ExternalSensors::read(JsonObject &root) {
+void ExternalSensors::read(CoolTelemetry &telemetry) {
   if (sensorsNumber > 0) {
     for (uint8_t i = 0; i < sensorsNumber; i++) {
       if (sensors[i].exSensor != NULL) {
-        root.createNestedObject(sensors[i].key);
+        bool nested = true;
+
+        telemetry.beginObject(sensors[i].key.c_str());
         if (sensors[i].reference == "Adafruit_TCS34725") {
           int16_t r, g, b, c, colorTemp, lux;
 
           sensors[i].exSensor->read(&r, &g, &b, &c, &colorTemp, &lux);
-          root[sensors[i].key][sensors[i].kind0] = r;
-          root[sensors[i].key][sensors[i].kind1] = g;
-          root[sensors[i].key][sensors[i].kind2] = b;
-          root[sensors[i].key][sensors[i].kind3] = c;
+          telemetry.add(sensors[i].kind0.c_str(), r);
+          telemetry.add(sensors[i].kind1.c_str(), g);
+          telemetry.add(sensors[i].kind2.c_str(), b);
+          telemetry.add(sensors[i].kind3.c_str(), c);
         } else if (sensors[i].reference == "Adafruit_CCS811") {
           int16_t C, V;
           float T;
 
           sensors[i].exSensor->read(&C, &V, &T);
-          root[sensors[i].key][sensors[i].kind0] = C;
-          root[sensors[i].key][sensors[i].kind1] = V;
-          root[sensors[i].key][sensors[i].kind2] = T;
+          telemetry.add(sensors[i].kind0.c_str(), C);
+          telemetry.add(sensors[i].kind1.c_str(), V);
+          telemetry.add(sensors[i].kind2.c_str(), T);
         } else if ((sensors[i].reference == "Adafruit_ADS1015") ||
                    (sensors[i].reference == "Adafruit_ADS1115")) {
           int16_t channel0, channel1, channel2, channel3;
@@ -160,39 +162,41 @@ void ExternalSensors::read(JsonObject &root) {
           gain1 = gain1 / 512;
           gain2 = gain2 / 512;
           gain3 = gain3 / 512;
-          root[sensors[i].key]["0_" + sensors[i].kind0] = channel0;
-          root[sensors[i].key]["G0_" + sensors[i].kind0] = gain0;
-          root[sensors[i].key]["1_" + sensors[i].kind1] = channel1;
-          root[sensors[i].key]["G1_" + sensors[i].kind1] = gain1;
-          root[sensors[i].key]["2_" + sensors[i].kind2] = channel2;
-          root[sensors[i].key]["G2_" + sensors[i].kind2] = gain2;
-          root[sensors[i].key]["3_" + sensors[i].kind3] = channel3;
-          root[sensors[i].key]["G3_" + sensors[i].kind3] = gain3;
+          telemetry.add(("0_" + sensors[i].kind0).c_str(), channel0);
+          telemetry.add(("G0_" + sensors[i].kind0).c_str(), gain0);
+          telemetry.add(("1_" + sensors[i].kind1).c_str(), channel1);
+          telemetry.add(("G1_" + sensors[i].kind1).c_str(), gain1);
+          telemetry.add(("2_" + sensors[i].kind2).c_str(), channel2);
+          telemetry.add(("G2_" + sensors[i].kind2).c_str(), gain2);
+          telemetry.add(("3_" + sensors[i].kind3).c_str(), channel3);
+          telemetry.add(("G3_" + sensors[i].kind3).c_str(), gain3);
         } else if (sensors[i].reference == "CoolGauge") {
           uint32_t A, B, C;
           sensors[i].exSensor->read(&A, &B, &C);
-          root[sensors[i].key][sensors[i].kind0] = A;
-          root[sensors[i].key][sensors[i].kind1] = B;
-          root[sensors[i].key][sensors[i].kind2] = C;
+          telemetry.add(sensors[i].kind0.c_str(), A);
+          telemetry.add(sensors[i].kind1.c_str(), B);
+          telemetry.add(sensors[i].kind2.c_str(), C);
         } else if (sensors[i].reference == "SHT1X") {
           float A, B;
           sensors[i].exSensor->read(&A, &B);
-          root[sensors[i].key][sensors[i].kind0] = A;
-          root[sensors[i].key][sensors[i].kind1] = B;
+          telemetry.add(sensors[i].kind0.c_str(), A);
+          telemetry.add(sensors[i].kind1.c_str(), B);
         } else if (sensors[i].reference == "SDS011") {
           float A, B;
           sensors[i].exSensor->read(&A, &B);
           delay(200);
-          root[sensors[i].key][sensors[i].kind0] = A; //PM10
-          root[sensors[i].key][sensors[i].kind1] = B; //PM2.5
+          telemetry.add(sensors[i].kind0.c_str(), A); //PM10
+          telemetry.add(sensors[i].kind1.c_str(), B); //PM2.5
         } else if (sensors[i].reference == "MCP342X_4-20mA") {
           int16_t channel0, channel1, channel2, channel3;
 
           sensors[i].exSensor->read(&channel0, &channel1, &channel2, &channel3);
-          root[sensors[i].kind0] = channel0;
-          root[sensors[i].kind1] = channel1;
-          root[sensors[i].kind2] = channel2;
-          root[sensors[i].kind3] = channel3;
+          telemetry.endObject();
+          nested = false;
+          telemetry.add(sensors[i].kind0.c_str(), channel0);
+          telemetry.add(sensors[i].kind1.c_str(), channel1);
+          telemetry.add(sensors[i].kind2.c_str(), channel2);
+          telemetry.add(sensors[i].kind3.c_str(), channel3);
           DEBUG_VAR("MCP342X Channel 1 Output:",channel0);
           DEBUG_VAR("MCP342X Channel 2 Output:",channel1);
           DEBUG_VAR("MCP342X Channel 3 Output:",channel2);
@@ -204,27 +208,33 @@ void ExternalSensors::read(JsonObject &root) {
           DEBUG_VAR("ChirpSoilMoisture Address:",sensors[i].address);
           DEBUG_VAR("SoilMoisture RAW:", A);
           DEBUG_VAR("SoilTemperature:", B);
-          root[sensors[i].kind0] = A; 
-          root[sensors[i].kind1] = B;
+          telemetry.endObject();
+          nested = false;
+          telemetry.add(sensors[i].kind0.c_str(), A);
+          telemetry.add(sensors[i].kind1.c_str(), B);
         } else if (sensors[i].reference == "BME280") {
           float A, B, C;
           sensors[i].exSensor->read(&A, &B, &C);
-          root[sensors[i].kind0] = A; 
-          root[sensors[i].kind1] = B;
-          root[sensors[i].kind2] = C;
+          telemetry.endObject();
+          nested = false;
+          telemetry.add(sensors[i].kind0.c_str(), A);
+          telemetry.add(sensors[i].kind1.c_str(), B);
+          telemetry.add(sensors[i].kind2.c_str(), C);
           DEBUG_VAR("external BME280 @ I2C address:", sensors[i].address);
           DEBUG_VAR("Temperature : ", A);
           DEBUG_VAR("Pressure : ", B);
           DEBUG_VAR("Humidity : ", C);
         } else {
-          root[sensors[i].key][sensors[i].kind0] = sensors[i].exSensor->read();
+          telemetry.add(sensors[i].kind0.c_str(), sensors[i].exSensor->read());
+        }
+        if (nested) {
+          telemetry.endObject();
         }
       } else {
         ERROR_VAR("Undefined (NULL) external sensor at index #", i); 
       }   
     }   
   }
-  DEBUG_JSON("External sensors data:", root);
 }
 
 bool ExternalSensors::config() {
@@ -267,6 +277,37 @@ bool ExternalSensors::config() {
   return (true);
 }
 
+void ExternalSensors::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->sensorsNumber);
+  for (uint8_t i = 0; i < this->sensorsNumber; i++) {
+    snapshot.put(this->sensors[i].reference);
+    snapshot.put(this->sensors[i].key);
+    snapshot.put(this->sensors[i].address);
+    snapshot.put(this->sensors[i].kind0);
+    snapshot.put(this->sensors[i].kind1);
+    snapshot.put(this->sensors[i].kind2);
+    snapshot.put(this->sensors[i].kind3);
+  }
+}
+
+bool ExternalSensors::restore(CoolSnapshot &snapshot) {
+  if (!snapshot.get(this->sensorsNumber) || this->sensorsNumber >
+          sizeof(this->sensors) / sizeof(this->sensors[0])) {
+    return (false);
+  }
+  for (uint8_t i = 0; i < this->sensorsNumber; i++) {
+    snapshot.get(this->sensors[i].reference);
+    snapshot.get(this->sensors[i].key);
+    snapshot.get(this->sensors[i].address);
+    snapshot.get(this->sensors[i].kind0);
+    snapshot.get(this->sensors[i].kind1);
+    snapshot.get(this->sensors[i].kind2);
+    snapshot.get(this->sensors[i].kind3);
+  }
+  this->printConf(this->sensors);
+  return (snapshot.isValid());
+}
+
 void ExternalSensors::printConf(Sensor sensors[]) {
   INFO_LOG("External sensors configuration");
   INFO_VAR("Number of external sensors =", this->sensorsNumber);
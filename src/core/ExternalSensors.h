@@ -28,13 +28,17 @@
 
 #include "ExternalSensor.h"
 #include "CoolMessagePack.h"
+#include "CoolSnapshot.h"
+#include "CoolTelemetry.h"
 
 class ExternalSensors {
 
 public:
   void begin();
-  void read(JsonObject &root);
+  void read(CoolTelemetry &telemetry);
   bool config();
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
 
 private:
   struct Sensor {
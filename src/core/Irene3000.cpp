@@ -53,7 +53,7 @@ bool Irene3000::isButtonPressed() {
   return false;
 }
 
-void Irene3000::calibrate(CoolBoardLed &led) {
+bool Irene3000::calibrate(CoolBoardLed &led) {
   led.write(WHITE);
   INFO_LOG("IRN3000 starting, hold button to calibrate the pH probe");
   delay(2000);
@@ -81,33 +81,37 @@ void Irene3000::calibrate(CoolBoardLed &led) {
     INFO_LOG("Calibration finished, hold button to exit calibration");
     this->waitForButtonPress();
     led.write(OFF);
+    return (true);
   }
+  return (false);
 }
 
-void Irene3000::read(JsonObject &root) {
+void Irene3000::read(CoolTelemetry &telemetry) {
   if (waterTemp.active) {
-    root.createNestedObject("PT1000");
-    this->readTemp(root["PT1000"]);
+    telemetry.beginObject("PT1000");
+    this->readTemp(telemetry);
+    telemetry.endObject();
     if (phProbe.active) {
-      root.createNestedObject("phProbe");
-      this->readPh(root["phProbe"]);
-      // readLastCalibrationDate(root);
+      telemetry.beginObject("phProbe");
+      this->readPh(telemetry);
+      telemetry.endObject();
+      // readLastCalibrationDate(telemetry);
     }
   }
   if (adc2.active) {
-    root.createNestedObject("adc2");
+    telemetry.beginObject("adc2");
     if (this->adc2.type == "DFrobotEC") {
-      this->readEC(root["adc2"]);
+      this->readEC(telemetry);
     } else {
-      root["adc2"][adc2.type] = this->readADSChannel2();
+      telemetry.add(this->adc2.type.c_str(), this->readADSChannel2());
     }
+    telemetry.endObject();
   }
-  DEBUG_JSON("Irene data:", root);
 }
 
 bool Irene3000::config(bool overwrite) {
   CoolConfig config("/sensors.json");
-  if (!config.readFileAsJson()) {
+  if (!config.readFileAsJson(overwrite)) {
     ERROR_LOG("Failed to read /sensors.json");
     return (false);
   }
@@ -171,6 +175,31 @@ bool Irene3000::config(bool overwrite) {
   return (true);
 }
 
+void Irene3000::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->params.pH7Cal);
+  snapshot.put(this->params.pH4Cal);
+  snapshot.put(this->params.pHStep);
+  snapshot.put(this->params.calibrationDate);
+  snapshot.put(this->waterTemp.active);
+  snapshot.put(this->phProbe.active);
+  snapshot.put(this->adc2.active);
+  snapshot.put(this->adc2.gain);
+  snapshot.put(this->adc2.type);
+}
+
+bool Irene3000::restore(CoolSnapshot &snapshot) {
+  snapshot.get(this->params.pH7Cal);
+  snapshot.get(this->params.pH4Cal);
+  snapshot.get(this->params.pHStep);
+  snapshot.get(this->params.calibrationDate);
+  snapshot.get(this->waterTemp.active);
+  snapshot.get(this->phProbe.active);
+  snapshot.get(this->adc2.active);
+  snapshot.get(this->adc2.gain);
+  snapshot.get(this->adc2.type);
+  return (snapshot.isValid());
+}
+
 void Irene3000::printConf() {
   DEBUG_LOG("IRN3000 configuration");
   DEBUG_VAR("  Temperature enabled:", waterTemp.active);
@@ -197,7 +226,7 @@ int Irene3000::readADSChannel2() {
   return (result);
 }
 
-void Irene3000::readPh(JsonObject &root) {
+void Irene3000::readPh(CoolTelemetry &telemetry) {
   this->ads.setGain(GAIN_FOUR);
 
   int adcR = ads.readADC_SingleEnded(PH_CHANNEL);
@@ -210,12 +239,12 @@ void Irene3000::readPh(JsonObject &root) {
 
   DEBUG_VAR("ph value:", phT);
   if (isnan(phT)) {
-    root["ph"] = RawJson("null");
+    telemetry.addNull("ph");
   } else
-    root["ph"] = phT;
+    telemetry.add("ph", phT);
 }
 
-void Irene3000::readTemp(JsonObject &root) {
+void Irene3000::readTemp(CoolTelemetry &telemetry) {
   const double A = 3.9083E-3;
   const double B = -5.775E-7;
   double T;
@@ -231,9 +260,9 @@ void Irene3000::readTemp(JsonObject &root) {
 
   DEBUG_VAR("IRN3000 temperature in °C: ", T);
   if (T > 0 && T < 200) {
-    root["waterTemp"] = T;
+    telemetry.add("waterTemp", T);
   } else {
-    root["waterTemp"] = RawJson("null");
+    telemetry.addNull("waterTemp");
   }
 }
 
@@ -254,7 +283,7 @@ float Irene3000::readTemp() {
   return T;
 }
 
-void Irene3000::readEC(JsonObject &root) {
+void Irene3000::readEC(CoolTelemetry &telemetry) {
   int overSample = 16;
   float ecCurrent = 0;
   unsigned long average = 0;
@@ -285,7 +314,7 @@ void Irene3000::readEC(JsonObject &root) {
   // convert us/cm to ms/cm
   ecCurrent /= 1000;
   DEBUG_VAR("EC value", ecCurrent);
-  root["EC"] = ecCurrent;
+  telemetry.add("EC", ecCurrent);
 }
 
 void Irene3000::calibratepH7() {
@@ -306,14 +335,14 @@ void Irene3000::saveCalibrationDate() {
   this->params.calibrationDate = CoolTime::getInstance().getIso8601DateTime();
 }
 
-void Irene3000::readLastCalibrationDate(JsonObject &root) {
+void Irene3000::readLastCalibrationDate(CoolTelemetry &telemetry) {
   String calibrationDate = params.calibrationDate;
   DEBUG_VAR("laste calibration date: ", calibrationDate);
   if (calibrationDate == "0000-00-00T00:00:00Z") {
     ERROR_LOG("PH calibration date error");
-    root["calibrationDate"] = RawJson("null");
+    telemetry.addNull("calibrationDate");
   } else {
-    root["calibrationDate"] = calibrationDate;
+    telemetry.add("calibrationDate", calibrationDate);
   }
 }
 
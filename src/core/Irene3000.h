@@ -28,6 +28,8 @@
 #include "CoolAdafruit_ADS1015.h"
 #include "CoolBoardLed.h"
 #include "CoolMessagePack.h"
+#include "CoolSnapshot.h"
+#include "CoolTelemetry.h"
 
 #define ADC_MAXIMUM_VALUE 32767
 #define REFERENCE_VOLTAGE_GAIN_4 1.024
@@ -48,24 +50,26 @@ class Irene3000 {
 public:
   void begin();
   bool config(bool overWrite = false);
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
   void printConf();
-  void read(JsonObject &root);
+  void read(CoolTelemetry &telemetry);
   int readButton();
   int readADSChannel2();
-  void readPh(JsonObject &root);
-  void readTemp(JsonObject &root);
-  void readEC(JsonObject &root);
+  void readPh(CoolTelemetry &telemetry);
+  void readTemp(CoolTelemetry &telemetry);
+  void readEC(CoolTelemetry &telemetry);
   float readTemp();
   void resetParams();
   void calibratepH7();
   void calibratepH4();
   void saveCalibrationDate();
-  void readLastCalibrationDate(JsonObject &root);
+  void readLastCalibrationDate(CoolTelemetry &telemetry);
   void calcpHSlope();
   adsGain_t gainConvert(uint16_t tempGain);
   void waitForButtonPress();
   bool isButtonPressed();
-  void calibrate(CoolBoardLed &led);
+  bool calibrate(CoolBoardLed &led);
 
 private:
   Adafruit_ADS1115 ads;
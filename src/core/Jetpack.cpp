@@ -50,21 +50,24 @@ void Jetpack::writeBit(byte pin, bool state) {
   digitalWrite(JETPACK_I2C_ENABLE_PIN, HIGH);
 }
 
-void Jetpack::doAction(JsonObject &root, int hour, int minute) {
+void Jetpack::doAction(CoolTelemetry &telemetry, int hour, int minute) {
   bool state = false;
-  JsonArray &actuators =
-      root.createNestedObject("actuators").createNestedArray("enabled");
 
+  telemetry.beginObject("actuators");
+  telemetry.beginArray("enabled");
   for (int pin = 0; pin < this->sizeList; pin++) {
-    state = this->actuatorList[pin].doAction(
-        root[this->actuatorList[pin].primaryType], hour, minute);
-    actuators.add(state);
+    // measures are logged under "sample", never next to "actuators", so the
+    // former root[primaryType] lookup always yielded 0
+    state = this->actuatorList[pin].doAction(0, hour, minute);
+    telemetry.add(NULL, state);
     if (pin == 0) {
       this->actuatorList[pin].write(state);
     } else {
       bitWrite(this->action, pin - 1, state);
     }
   }
+  telemetry.endArray();
+  telemetry.endObject();
   this->write(this->action);
 }
 
@@ -94,6 +97,26 @@ bool Jetpack::config() {
   return (true);
 }
 
+void Jetpack::snapshot(CoolSnapshot &snapshot) {
+  snapshot.put(this->sizeList);
+  for (int i = 0; i < this->sizeList; i++) {
+    this->actuatorList[i].snapshot(snapshot);
+  }
+}
+
+bool Jetpack::restore(CoolSnapshot &snapshot) {
+  if (!snapshot.get(this->sizeList)) {
+    return (false);
+  }
+  this->actuatorList = new CoolBoardActuator[this->sizeList];
+  for (int i = 0; i < this->sizeList; i++) {
+    if (!this->actuatorList[i].restore(snapshot)) {
+      return (false);
+    }
+  }
+  return (true);
+}
+
 void Jetpack::printConf() {
   INFO_LOG("Jetpack configuration");
 
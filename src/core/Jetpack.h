@@ -29,6 +29,8 @@
 
 #include "CoolBoardActuator.h"
 #include "CoolMessagePack.h"
+#include "CoolSnapshot.h"
+#include "CoolTelemetry.h"
 
 #define JETPACK_CLOCK_PIN 4
 #define JETPACK_DATA_PIN 15
@@ -40,8 +42,10 @@ public:
   void begin();
   void write(byte action);
   void writeBit(byte pin, bool state);
-  void doAction(JsonObject &root, int hour, int minute);
+  void doAction(CoolTelemetry &telemetry, int hour, int minute);
   bool config();
+  void snapshot(CoolSnapshot &snapshot);
+  bool restore(CoolSnapshot &snapshot);
   void printConf();
 
   uint8_t sizeList;
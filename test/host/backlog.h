@@ -0,0 +1,142 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// helpers shared by the backlog tests
+
+#ifndef HOST_BACKLOG_H
+#define HOST_BACKLOG_H
+
+#include "test.h"
+
+#include "CoolBacklog.h"
+#include "CoolMessagePack.h"
+#include "CoolSnapshot.h"
+
+struct BacklogSettings {
+  uint32_t maxBytes;
+  uint32_t maxRecords;
+  BacklogEviction eviction;
+  bool compress;
+  bool staging;
+};
+
+// settings go through a snapshot, as on a warm boot
+inline void configure(const BacklogSettings &settings) {
+  CoolSnapshot saved;
+  CoolSnapshot loaded;
+  float maxFill = BACKLOG_DEFAULT_MAX_FILL;
+
+  saved.put(settings.maxBytes);
+  saved.put(settings.maxRecords);
+  saved.put(maxFill);
+  saved.put(settings.eviction);
+  saved.put(settings.compress);
+  saved.put(settings.staging);
+  CHECK(saved.save(1) && loaded.load(1));
+  CHECK(CoolBacklog::getInstance().restore(loaded));
+}
+
+// sample n is [n, padding], so that sizes vary like real samples do
+inline std::vector<uint8_t> sample(uint32_t n) {
+  Buffer out;
+
+  CoolMessagePack::writeArrayHeader(out, 2);
+  CoolMessagePack::writeInteger(out, n);
+  CoolMessagePack::writeString(out,
+                               std::string(5 + n % 23, 'a' + n % 26).c_str());
+  return (out.bytes);
+}
+
+inline bool append(uint32_t n) {
+  std::vector<uint8_t> data = sample(n);
+
+  return (CoolBacklog::getInstance().append(data.data(), data.size()));
+}
+
+inline bool sampleId(const uint8_t *data, size_t size, uint32_t &n) {
+  if (size < 3 || data[0] != 0x92) {
+    return (false);
+  }
+  if (data[1] < 0x80) {
+    n = data[1];
+  } else if (data[1] == 0xcc) {
+    n = data[2];
+  } else if (data[1] == 0xcd && size > 3) {
+    n = (data[2] << 8) | data[3];
+  } else {
+    return (false);
+  }
+  return (sample(n).size() == size &&
+          memcmp(sample(n).data(), data, size) == 0);
+}
+
+// every pending sample in sending order, false on a damaged record
+inline bool pending(std::vector<uint32_t> &ids) {
+  CoolBacklog &backlog = CoolBacklog::getInstance();
+  CoolBacklogCursor cursor = backlog.head();
+  uint8_t *data;
+  size_t size;
+
+  ids.clear();
+  while (backlog.read(cursor, data, size)) {
+    size_t rawSize = size;
+    uint8_t count = 1;
+    uint8_t *raw = data;
+    bool valid = data != NULL;
+
+    if (valid && CoolBacklog::isBlock(data, size)) {
+      raw = CoolBacklog::expand(data, size, rawSize, count);
+      valid = raw != NULL;
+    }
+    for (size_t offset = 0; valid && offset < rawSize;) {
+      size_t object =
+          CoolMessagePack::objectSize(raw + offset, rawSize - offset);
+      uint32_t n;
+
+      valid = object > 0 && sampleId(raw + offset, object, n);
+      ids.push_back(n);
+      offset += object;
+      count--;
+    }
+    valid = valid && count == 0;
+    if (raw != data) {
+      free(raw);
+    }
+    free(data);
+    if (!valid) {
+      return (false);
+    }
+  }
+  return (true);
+}
+
+inline std::vector<uint32_t> range(uint32_t from, uint32_t to) {
+  std::vector<uint32_t> ids;
+
+  for (uint32_t n = from; n < to; n++) {
+    ids.push_back(n);
+  }
+  return (ids);
+}
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// Host stand-in for the parts of the ESP8266 Arduino core used by the
+// modules under test. RTC user memory and the reset reason can be set by
+// the tests to simulate deep sleep wakes and power cuts. The free heap
+// counts the C++ allocations of the process against heapSize.
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+#define F(s) (s)
+#define HEX 16
+#define DEC 10
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void yield() {}
+
+class String : public std::string {
+
+public:
+  String() {}
+  String(const char *s) : std::string(s ? s : "") {}
+  String(const std::string &s) : std::string(s) {}
+  String(char c) : std::string(1, c) {}
+  String(int value) : std::string(std::to_string(value)) {}
+  String(unsigned int value) : std::string(std::to_string(value)) {}
+  String(long value) : std::string(std::to_string(value)) {}
+  String(unsigned long value) : std::string(std::to_string(value)) {}
+
+  unsigned int length() const { return (this->size()); }
+  bool endsWith(const char *suffix) const {
+    size_t n = strlen(suffix);
+    return (this->size() >= n &&
+            this->compare(this->size() - n, n, suffix) == 0);
+  }
+  String substring(size_t from) const { return (String(this->substr(from))); }
+  String substring(size_t from, size_t to) const {
+    return (String(this->substr(from, to - from)));
+  }
+  long toInt() const { return (atol(this->c_str())); }
+};
+
+class Print {
+
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *data, size_t size) {
+    size_t n = 0;
+    while (n < size && this->write(data[n])) {
+      n++;
+    }
+    return (n);
+  }
+  size_t write(const char *text) {
+    return (this->write((const uint8_t *)text, strlen(text)));
+  }
+};
+
+class Stream : public Print {
+
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+};
+
+enum rst_reason {
+  REASON_DEFAULT_RST = 0,
+  REASON_WDT_RST = 1,
+  REASON_EXCEPTION_RST = 2,
+  REASON_SOFT_WDT_RST = 3,
+  REASON_SOFT_RESTART = 4,
+  REASON_DEEP_SLEEP_AWAKE = 5,
+  REASON_EXT_SYS_RST = 6
+};
+
+struct rst_info {
+  uint32_t reason;
+};
+
+#define RTC_USER_MEMORY_SIZE 512
+
+class EspClass {
+
+public:
+  rst_info *getResetInfoPtr() { return (&this->resetInfo); }
+  uint32_t getFreeHeap();
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+
+  // host only: power cuts clear RTC memory, deep sleep keeps it
+  void powerOn();
+  void deepSleepWake();
+
+  rst_info resetInfo = {REASON_DEFAULT_RST};
+  uint32_t heapSize = 1 << 24;
+  uint8_t rtcMemory[RTC_USER_MEMORY_SIZE] = {};
+};
+
+extern EspClass ESP;
+
+#endif
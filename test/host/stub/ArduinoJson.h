@@ -0,0 +1,165 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// Host stand-in for ArduinoJson 5: enough of the API for the firmware
+// sources to compile. Every document is empty, so JSON paths build here
+// but are only exercised on the board. A buffer takes its capacity from
+// the heap and a parse reads the whole stream, as on the board.
+
+#ifndef HOST_ARDUINOJSON_H
+#define HOST_ARDUINOJSON_H
+
+#include <Arduino.h>
+
+// node sizes of ArduinoJson 5 on the ESP8266
+#define JSON_ARRAY_SIZE(n) (8 + (n)*12)
+#define JSON_OBJECT_SIZE(n) (8 + (n)*16)
+
+class JsonArray;
+class JsonObject;
+class JsonVariant;
+
+template <typename T> struct JsonAs { typedef T type; };
+template <> struct JsonAs<JsonArray> { typedef JsonArray &type; };
+template <> struct JsonAs<JsonObject> { typedef JsonObject &type; };
+
+class JsonVariant {
+
+public:
+  JsonVariant() {}
+  template <typename T> JsonVariant &operator=(const T &) { return (*this); }
+  bool success() const { return (false); }
+  template <typename T> bool is() const { return (false); }
+  template <typename T> typename JsonAs<T>::type as() const;
+  template <typename T> operator T() const { return (T()); }
+  operator JsonArray &() const;
+  operator JsonObject &() const;
+  JsonVariant operator[](const char *) const { return (JsonVariant()); }
+  JsonVariant operator[](size_t) const { return (JsonVariant()); }
+  size_t printTo(Print &) const { return (0); }
+  size_t measureLength() const { return (0); }
+};
+
+struct JsonPair {
+  const char *key;
+  JsonVariant value;
+};
+
+class JsonArray {
+
+public:
+  bool success() const { return (false); }
+  size_t size() const { return (0); }
+  JsonVariant *begin() { return (NULL); }
+  JsonVariant *end() { return (NULL); }
+  JsonVariant operator[](size_t) const { return (JsonVariant()); }
+  size_t printTo(Print &) const { return (0); }
+  static JsonArray &invalid() {
+    static JsonArray array;
+    return (array);
+  }
+};
+
+class JsonObject {
+
+public:
+  bool success() const { return (false); }
+  size_t size() const { return (0); }
+  JsonPair *begin() { return (NULL); }
+  JsonPair *end() { return (NULL); }
+  JsonVariant operator[](const char *) const { return (JsonVariant()); }
+  JsonVariant operator[](const String &) const { return (JsonVariant()); }
+  size_t printTo(Print &) const { return (0); }
+  static JsonObject &invalid() {
+    static JsonObject object;
+    return (object);
+  }
+};
+
+template <typename T> inline typename JsonAs<T>::type JsonVariant::as() const {
+  return (T());
+}
+
+template <> inline JsonArray &JsonVariant::as<JsonArray>() const {
+  return (JsonArray::invalid());
+}
+
+template <> inline JsonObject &JsonVariant::as<JsonObject>() const {
+  return (JsonObject::invalid());
+}
+
+template <> inline JsonArray &JsonVariant::as<JsonArray &>() const {
+  return (JsonArray::invalid());
+}
+
+template <> inline JsonObject &JsonVariant::as<JsonObject &>() const {
+  return (JsonObject::invalid());
+}
+
+inline JsonVariant::operator JsonArray &() const {
+  return (JsonArray::invalid());
+}
+
+inline JsonVariant::operator JsonObject &() const {
+  return (JsonObject::invalid());
+}
+
+#define HOST_JSON_COMPARE(op)                                                  \
+  template <typename T>                                                        \
+  inline bool operator op(const JsonVariant &left, const T &right) {           \
+    return (left.as<T>() op right);                                            \
+  }
+HOST_JSON_COMPARE(<)
+HOST_JSON_COMPARE(<=)
+HOST_JSON_COMPARE(>)
+HOST_JSON_COMPARE(>=)
+HOST_JSON_COMPARE(==)
+HOST_JSON_COMPARE(!=)
+#undef HOST_JSON_COMPARE
+
+class DynamicJsonBuffer {
+
+public:
+  DynamicJsonBuffer(size_t capacity = 0)
+      : block(capacity ? new char[capacity] : NULL) {}
+  ~DynamicJsonBuffer() { delete[] this->block; }
+  DynamicJsonBuffer(DynamicJsonBuffer const &) = delete;
+  void operator=(DynamicJsonBuffer const &) = delete;
+  size_t size() const { return (0); }
+  JsonObject &createObject() { return (JsonObject::invalid()); }
+  JsonArray &createArray() { return (JsonArray::invalid()); }
+  JsonVariant parse(Stream &input) {
+    while (input.available()) {
+      input.read();
+    }
+    return (JsonVariant());
+  }
+  template <typename T> JsonObject &parseObject(T) {
+    return (JsonObject::invalid());
+  }
+
+private:
+  char *block;
+};
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// Host stand-in for the SPIFFS API, backed by memory. host::cutAfter()
+// arms a power cut: once that many bytes, truncations, renames and
+// removals went through, the next one throws host::PowerCut and leaves
+// the files as they were at that point.
+
+#ifndef HOST_FS_H
+#define HOST_FS_H
+
+#include <Arduino.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace host {
+
+struct PowerCut {};
+
+typedef std::map<std::string, std::vector<uint8_t>> Files;
+
+extern Files files;
+
+void cutAfter(long operations);
+void disarm();
+bool armed();
+void spend();
+long spent();
+
+// flash and RTC memory image, carried from one simulated boot to the next
+bool save(const char *path);
+bool load(const char *path);
+
+} // namespace host
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+
+public:
+  File() {}
+  File(const std::string &name, size_t position)
+      : path(name), position_(position), open(true) {}
+
+  operator bool() const { return (this->open); }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *data, size_t size) override;
+  int available() override;
+  int read() override;
+  size_t read(uint8_t *data, size_t size);
+  bool seek(uint32_t position, SeekMode mode = SeekSet);
+  size_t position() const { return (this->position_); }
+  size_t size() const;
+  const char *name() const { return (this->path.c_str()); }
+  void close() { this->open = false; }
+
+private:
+  std::string path;
+  size_t position_ = 0;
+  bool open = false;
+};
+
+class Dir {
+
+public:
+  bool next();
+  String fileName() const { return (String(this->names[this->current])); }
+  size_t fileSize() const;
+
+  std::vector<std::string> names;
+  int current = -1;
+};
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+class SPIFFSClass {
+
+public:
+  bool begin() { return (true); }
+  void end() {}
+  File open(const String &path, const char *mode);
+  bool exists(const String &path);
+  bool remove(const String &path);
+  bool rename(const String &from, const String &to);
+  Dir openDir(const String &path);
+  bool info(FSInfo &info);
+
+  size_t totalBytes = 1 << 20;
+};
+
+extern SPIFFSClass SPIFFS;
+
+#endif
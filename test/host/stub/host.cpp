@@ -0,0 +1,302 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include <chrono>
+#include <malloc.h>
+#include <new>
+
+EspClass ESP;
+SPIFFSClass SPIFFS;
+
+namespace host {
+
+Files files;
+
+static long budget = -1;
+static long operations = 0;
+
+void cutAfter(long operations) { budget = operations; }
+
+void disarm() { budget = -1; }
+
+bool armed() { return (budget >= 0); }
+
+void spend() {
+  if (budget == 0) {
+    throw PowerCut();
+  }
+  if (budget > 0) {
+    budget--;
+  }
+  operations++;
+}
+
+long spent() { return (operations); }
+
+bool save(const char *path) {
+  FILE *f = fopen(path, "wb");
+  uint32_t count = files.size();
+  bool success = f != NULL &&
+                 fwrite(&ESP.resetInfo, sizeof(ESP.resetInfo), 1, f) == 1 &&
+                 fwrite(ESP.rtcMemory, sizeof(ESP.rtcMemory), 1, f) == 1 &&
+                 fwrite(&count, sizeof(count), 1, f) == 1;
+
+  for (Files::iterator file = files.begin(); success && file != files.end();
+       ++file) {
+    uint32_t sizes[2] = {(uint32_t)file->first.size(),
+                         (uint32_t)file->second.size()};
+
+    success = fwrite(sizes, sizeof(sizes), 1, f) == 1 &&
+              fwrite(file->first.data(), 1, sizes[0], f) == sizes[0] &&
+              fwrite(file->second.data(), 1, sizes[1], f) == sizes[1];
+  }
+  if (f != NULL) {
+    fclose(f);
+  }
+  return (success);
+}
+
+bool load(const char *path) {
+  FILE *f = fopen(path, "rb");
+  uint32_t count = 0;
+  bool success = f != NULL &&
+                 fread(&ESP.resetInfo, sizeof(ESP.resetInfo), 1, f) == 1 &&
+                 fread(ESP.rtcMemory, sizeof(ESP.rtcMemory), 1, f) == 1 &&
+                 fread(&count, sizeof(count), 1, f) == 1;
+
+  files.clear();
+  for (uint32_t i = 0; success && i < count; i++) {
+    uint32_t sizes[2];
+    std::string name;
+
+    success = fread(sizes, sizeof(sizes), 1, f) == 1;
+    name.resize(success ? sizes[0] : 0);
+    success = success && fread(&name[0], 1, sizes[0], f) == sizes[0];
+    std::vector<uint8_t> &file = files[name];
+    file.resize(success ? sizes[1] : 0);
+    success = success && fread(file.data(), 1, sizes[1], f) == sizes[1];
+  }
+  if (f != NULL) {
+    fclose(f);
+  }
+  return (success);
+}
+
+} // namespace host
+
+static size_t heapUsed = 0;
+
+void *operator new(size_t size) {
+  void *block = malloc(size ? size : 1);
+
+  if (!block) {
+    throw std::bad_alloc();
+  }
+  heapUsed += malloc_usable_size(block);
+  return (block);
+}
+
+void operator delete(void *block) noexcept {
+  if (block) {
+    heapUsed -= malloc_usable_size(block);
+    free(block);
+  }
+}
+
+static std::chrono::steady_clock::time_point start =
+    std::chrono::steady_clock::now();
+
+unsigned long millis() { return (micros() / 1000); }
+
+unsigned long micros() {
+  return (std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - start)
+              .count());
+}
+
+void delay(unsigned long ms) { (void)ms; }
+
+uint32_t EspClass::getFreeHeap() {
+  return (this->heapSize > heapUsed ? this->heapSize - heapUsed : 0);
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data,
+                                 size_t size) {
+  if (offset * 4 + size > RTC_USER_MEMORY_SIZE) {
+    return (false);
+  }
+  memcpy(data, this->rtcMemory + offset * 4, size);
+  return (true);
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data,
+                                  size_t size) {
+  if (offset * 4 + size > RTC_USER_MEMORY_SIZE) {
+    return (false);
+  }
+  memcpy(this->rtcMemory + offset * 4, data, size);
+  return (true);
+}
+
+void EspClass::powerOn() {
+  this->resetInfo.reason = REASON_DEFAULT_RST;
+  memset(this->rtcMemory, 0, sizeof(this->rtcMemory));
+}
+
+void EspClass::deepSleepWake() {
+  this->resetInfo.reason = REASON_DEEP_SLEEP_AWAKE;
+}
+
+size_t File::write(uint8_t c) { return (this->write(&c, 1)); }
+
+size_t File::write(const uint8_t *data, size_t size) {
+  if (!this->open) {
+    return (0);
+  }
+  std::vector<uint8_t> &file = host::files[this->path];
+  for (size_t i = 0; i < size; i++) {
+    host::spend();
+    if (this->position_ < file.size()) {
+      file[this->position_] = data[i];
+    } else {
+      file.push_back(data[i]);
+    }
+    this->position_++;
+  }
+  return (size);
+}
+
+int File::available() {
+  return (this->open ? (int)(this->size() - min(this->size(), this->position_))
+                     : 0);
+}
+
+int File::read() {
+  uint8_t c;
+
+  return (this->read(&c, 1) == 1 ? c : -1);
+}
+
+size_t File::read(uint8_t *data, size_t size) {
+  if (!this->open || !host::files.count(this->path)) {
+    return (0);
+  }
+  std::vector<uint8_t> &file = host::files[this->path];
+  size_t n = this->position_ < file.size()
+                 ? min(size, file.size() - this->position_)
+                 : 0;
+  memcpy(data, file.data() + this->position_, n);
+  this->position_ += n;
+  return (n);
+}
+
+bool File::seek(uint32_t position, SeekMode mode) {
+  long target = position;
+
+  if (mode == SeekCur) {
+    target += this->position_;
+  } else if (mode == SeekEnd) {
+    target += this->size();
+  }
+  if (!this->open || target < 0 || (size_t)target > this->size()) {
+    return (false);
+  }
+  this->position_ = target;
+  return (true);
+}
+
+size_t File::size() const {
+  host::Files::const_iterator file = host::files.find(this->path);
+
+  return (file == host::files.end() ? 0 : file->second.size());
+}
+
+bool Dir::next() { return (++this->current < (int)this->names.size()); }
+
+size_t Dir::fileSize() const {
+  return (host::files[this->names[this->current]].size());
+}
+
+File SPIFFSClass::open(const String &path, const char *mode) {
+  bool exists = host::files.count(path) > 0;
+
+  if (mode[0] == 'r' && !exists) {
+    return (File());
+  }
+  if (mode[0] == 'w') {
+    host::spend();
+    host::files[path].clear();
+  } else if (!exists) {
+    host::spend();
+    host::files[path];
+  }
+  return (File(path, mode[0] == 'a' ? host::files[path].size() : 0));
+}
+
+bool SPIFFSClass::exists(const String &path) {
+  return (host::files.count(path) > 0);
+}
+
+bool SPIFFSClass::remove(const String &path) {
+  if (!host::files.count(path)) {
+    return (false);
+  }
+  host::spend();
+  host::files.erase(path);
+  return (true);
+}
+
+bool SPIFFSClass::rename(const String &from, const String &to) {
+  if (!host::files.count(from) || host::files.count(to)) {
+    return (false);
+  }
+  host::spend();
+  host::files[to] = host::files[from];
+  host::files.erase(from);
+  return (true);
+}
+
+Dir SPIFFSClass::openDir(const String &path) {
+  Dir dir;
+
+  for (host::Files::iterator file = host::files.begin();
+       file != host::files.end(); ++file) {
+    if (file->first.compare(0, path.size(), path) == 0) {
+      dir.names.push_back(file->first);
+    }
+  }
+  return (dir);
+}
+
+bool SPIFFSClass::info(FSInfo &info) {
+  memset(&info, 0, sizeof(info));
+  info.totalBytes = this->totalBytes;
+  for (host::Files::iterator file = host::files.begin();
+       file != host::files.end(); ++file) {
+    info.usedBytes += file->second.size();
+  }
+  return (true);
+}
@@ -0,0 +1,133 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// Host stand-in for the msgpck writers used by CoolMessagePack. Integers
+// take the smallest MessagePack encoding of their value, the library may
+// pick a wider one for some values: tests check structure, not widths.
+
+#ifndef HOST_MSGPCK_H
+#define HOST_MSGPCK_H
+
+#include <Arduino.h>
+
+inline void msgpck_write_big_endian(Print *s, uint8_t type, uint32_t value,
+                                    uint8_t bytes) {
+  s->write(type);
+  for (uint8_t i = bytes; i > 0; i--) {
+    s->write((uint8_t)(value >> (8 * (i - 1))));
+  }
+}
+
+inline void msgpck_write_nil(Print *s) { s->write((uint8_t)0xc0); }
+
+inline void msgpck_write_bool(Print *s, bool b) {
+  s->write((uint8_t)(b ? 0xc3 : 0xc2));
+}
+
+inline void msgpck_write_integer(Print *s, uint32_t u) {
+  if (u < 0x80) {
+    s->write((uint8_t)u);
+  } else if (u <= 0xff) {
+    msgpck_write_big_endian(s, 0xcc, u, 1);
+  } else if (u <= 0xffff) {
+    msgpck_write_big_endian(s, 0xcd, u, 2);
+  } else {
+    msgpck_write_big_endian(s, 0xce, u, 4);
+  }
+}
+
+inline void msgpck_write_integer(Print *s, int32_t i) {
+  if (i >= 0) {
+    msgpck_write_integer(s, (uint32_t)i);
+  } else if (i >= -32) {
+    s->write((uint8_t)i);
+  } else if (i >= -128) {
+    msgpck_write_big_endian(s, 0xd0, (uint32_t)i & 0xff, 1);
+  } else if (i >= -32768) {
+    msgpck_write_big_endian(s, 0xd1, (uint32_t)i & 0xffff, 2);
+  } else {
+    msgpck_write_big_endian(s, 0xd2, (uint32_t)i, 4);
+  }
+}
+
+inline void msgpck_write_integer(Print *s, uint8_t u) {
+  msgpck_write_integer(s, (uint32_t)u);
+}
+
+inline void msgpck_write_integer(Print *s, uint16_t u) {
+  msgpck_write_integer(s, (uint32_t)u);
+}
+
+inline void msgpck_write_integer(Print *s, int8_t i) {
+  msgpck_write_integer(s, (int32_t)i);
+}
+
+inline void msgpck_write_integer(Print *s, int16_t i) {
+  msgpck_write_integer(s, (int32_t)i);
+}
+
+inline void msgpck_write_float(Print *s, float f) {
+  uint32_t bits;
+
+  memcpy(&bits, &f, sizeof(bits));
+  msgpck_write_big_endian(s, 0xca, bits, 4);
+}
+
+inline void msgpck_write_string(Print *s, char *str, uint32_t size) {
+  if (size < 32) {
+    s->write((uint8_t)(0xa0 | size));
+  } else if (size <= 0xff) {
+    msgpck_write_big_endian(s, 0xd9, size, 1);
+  } else if (size <= 0xffff) {
+    msgpck_write_big_endian(s, 0xda, size, 2);
+  } else {
+    msgpck_write_big_endian(s, 0xdb, size, 4);
+  }
+  s->write((const uint8_t *)str, size);
+}
+
+inline void msgpck_write_string(Print *s, String str) {
+  msgpck_write_string(s, (char *)str.c_str(), str.length());
+}
+
+inline void msgpck_write_array_header(Print *s, uint32_t size) {
+  if (size < 16) {
+    s->write((uint8_t)(0x90 | size));
+  } else if (size <= 0xffff) {
+    msgpck_write_big_endian(s, 0xdc, size, 2);
+  } else {
+    msgpck_write_big_endian(s, 0xdd, size, 4);
+  }
+}
+
+inline void msgpck_write_map_header(Print *s, uint32_t size) {
+  if (size < 16) {
+    s->write((uint8_t)(0x80 | size));
+  } else if (size <= 0xffff) {
+    msgpck_write_big_endian(s, 0xde, size, 2);
+  } else {
+    msgpck_write_big_endian(s, 0xdf, size, 4);
+  }
+}
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,         \
+              #condition);                                                     \
+      exit(1);                                                                 \
+    }                                                                          \
+  } while (0)
+
+#define TEST_IMAGE "build/board.img"
+#define POWER_CUT 3
+
+class Buffer : public Print {
+
+public:
+  size_t write(uint8_t c) override {
+    this->bytes.push_back(c);
+    return (1);
+  }
+  size_t write(const uint8_t *data, size_t size) override {
+    this->bytes.insert(this->bytes.end(), data, data + size);
+    return (size);
+  }
+  const uint8_t *data() const { return (this->bytes.data()); }
+  size_t size() const { return (this->bytes.size()); }
+
+  std::vector<uint8_t> bytes;
+};
+
+// one boot of the board, in a child process so that every singleton starts
+// from scratch: flash and RTC memory go through TEST_IMAGE in between. A
+// power cut ends the boot with POWER_CUT and clears RTC memory
+template <typename Body> int boot(Body body) {
+  fflush(stdout);
+  fflush(stderr);
+  pid_t pid = fork();
+  if (pid == 0) {
+    int status = 0;
+
+    CHECK(host::load(TEST_IMAGE));
+    try {
+      status = body();
+    } catch (host::PowerCut &) {
+      host::disarm();
+      ESP.powerOn();
+      status = POWER_CUT;
+    }
+    CHECK(host::save(TEST_IMAGE));
+    fflush(stdout);
+    _exit(status);
+  }
+  int status = 0;
+  CHECK(pid > 0 && waitpid(pid, &status, 0) == pid);
+  return (WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+}
+
+inline void powerOn() {
+  host::files.clear();
+  ESP.powerOn();
+  CHECK(host::save(TEST_IMAGE));
+}
+
+#endif
@@ -0,0 +1,254 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// backlog records across deep sleep, power cuts, compaction and quotas
+
+#include "backlog.h"
+
+static const BacklogSettings PLAIN = {0, 0, EVICT_DROP_OLDEST, false, false};
+
+static void expect(const BacklogSettings &settings, uint32_t from,
+                   uint32_t to) {
+  CHECK(boot([&]() {
+          std::vector<uint32_t> ids;
+
+          configure(settings);
+          CHECK(pending(ids));
+          CHECK(ids == range(from, to));
+          CHECK(CoolBacklog::getInstance().count() >= (to - from + 255) / 256);
+          return (0);
+        }) == 0);
+}
+
+static void testAppend() {
+  powerOn();
+  CHECK(boot([]() {
+          configure(PLAIN);
+          CHECK(CoolBacklog::getInstance().isEmpty());
+          // about 30 bytes each, enough to fill three segments
+          for (uint32_t n = 0; n < 400; n++) {
+            CHECK(append(n));
+          }
+          CHECK(CoolBacklog::getInstance().count() == 400);
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  CHECK(host::files.empty());
+  CHECK(host::load(TEST_IMAGE));
+  CHECK(host::files.count("/log/2.seg") && !host::files.count("/log/4.seg"));
+  expect(PLAIN, 0, 400);
+
+  // after a power cut the index is rebuilt from the segments
+  CHECK(host::load(TEST_IMAGE));
+  ESP.powerOn();
+  CHECK(host::save(TEST_IMAGE));
+  expect(PLAIN, 0, 400);
+}
+
+static void testCommit() {
+  CHECK(boot([]() {
+          CoolBacklog &backlog = CoolBacklog::getInstance();
+          CoolBacklogCursor cursor;
+          uint8_t *data;
+          size_t size;
+
+          configure(PLAIN);
+          cursor = backlog.head();
+          // the first segment and part of the second one
+          for (int i = 0; i < 200; i++) {
+            CHECK(backlog.read(cursor, data, size) && data != NULL);
+            free(data);
+          }
+          CHECK(backlog.commit(cursor));
+          CHECK(backlog.count() == 200);
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  CHECK(host::load(TEST_IMAGE));
+  CHECK(!host::files.count("/log/0.seg"));
+  expect(PLAIN, 200, 400);
+
+  CHECK(host::load(TEST_IMAGE));
+  ESP.powerOn();
+  CHECK(host::save(TEST_IMAGE));
+  expect(PLAIN, 200, 400);
+}
+
+static void testCompress() {
+  const BacklogSettings packed = {0, 0, EVICT_DROP_OLDEST, true, false};
+
+  CHECK(boot([&]() {
+          CoolBacklog &backlog = CoolBacklog::getInstance();
+
+          configure(packed);
+          backlog.compact();
+          // whole segments are packed into blocks of many samples
+          CHECK(backlog.count() < 200 / 2);
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  expect(packed, 200, 400);
+  CHECK(host::load(TEST_IMAGE));
+  ESP.powerOn();
+  CHECK(host::save(TEST_IMAGE));
+  expect(packed, 200, 400);
+}
+
+static void testCompact() {
+  powerOn();
+  CHECK(boot([]() {
+          CoolBacklog &backlog = CoolBacklog::getInstance();
+          CoolBacklogCursor cursor;
+          uint8_t *data;
+          size_t size;
+
+          configure(PLAIN);
+          for (uint32_t n = 0; n < 140; n++) {
+            CHECK(append(n));
+          }
+          size_t full = host::files["/log/0.seg"].size();
+          cursor = backlog.head();
+          for (int i = 0; i < 10; i++) {
+            CHECK(backlog.read(cursor, data, size) && data != NULL);
+            free(data);
+          }
+          CHECK(backlog.commit(cursor));
+          // a few sent logs are not worth rewriting the segment
+          long writes = host::spent();
+          backlog.compact();
+          CHECK(host::spent() == writes);
+          CHECK(host::files["/log/0.seg"].size() == full);
+          for (int i = 10; i < 130; i++) {
+            CHECK(backlog.read(cursor, data, size) && data != NULL);
+            free(data);
+          }
+          CHECK(backlog.commit(cursor));
+          backlog.compact();
+          CHECK(host::files["/log/0.seg"].size() < full / 4);
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  expect(PLAIN, 130, 140);
+}
+
+static void testStage() {
+  const BacklogSettings staged = {0, 0, EVICT_DROP_OLDEST, false, true};
+
+  powerOn();
+  CHECK(boot([&]() {
+          configure(staged);
+          for (uint32_t n = 0; n < 5; n++) {
+            CHECK(append(n));
+          }
+          CHECK(CoolBacklog::getInstance().staged() == 5);
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  CHECK(host::load(TEST_IMAGE));
+  // staged samples stay in RTC memory, flash is not written
+  CHECK(host::files.size() == 1 && host::files.count(SNAPSHOT_PATH));
+  CHECK(boot([&]() {
+          configure(staged);
+          CHECK(CoolBacklog::getInstance().staged() == 5);
+          for (uint32_t n = 5; n < 40; n++) {
+            CHECK(append(n));
+          }
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  expect(staged, 0, 40);
+
+  // online, staged samples are sent from RTC memory, not moved to flash
+  powerOn();
+  CHECK(boot([&]() {
+          CoolBacklog &backlog = CoolBacklog::getInstance();
+          std::vector<uint32_t> ids;
+          uint8_t *data;
+          size_t size;
+
+          configure(staged);
+          for (uint32_t n = 0; n < 5; n++) {
+            CHECK(append(n));
+          }
+          CHECK(pending(ids) && ids == range(0, 5));
+          CHECK(backlog.count() == 1 && !backlog.isEmpty());
+          CoolBacklogCursor cursor = backlog.head();
+          CHECK(backlog.read(cursor, data, size) && data != NULL);
+          free(data);
+          CHECK(!backlog.read(cursor, data, size));
+          CHECK(backlog.commit(cursor));
+          CHECK(backlog.isEmpty() && backlog.staged() == 0);
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  CHECK(host::load(TEST_IMAGE));
+  CHECK(host::files.size() == 1 && host::files.count(SNAPSHOT_PATH));
+  expect(staged, 0, 0);
+}
+
+static void testQuota() {
+  const BacklogSettings dropping = {0, 100, EVICT_DROP_OLDEST, false, false};
+  const BacklogSettings thinning = {0, 400, EVICT_DOWNSAMPLE, false, false};
+
+  powerOn();
+  CHECK(boot([&]() {
+          configure(dropping);
+          for (uint32_t n = 0; n < 300; n++) {
+            CHECK(append(n));
+          }
+          CHECK(CoolBacklog::getInstance().count() <= 100);
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  expect(dropping, 200, 300);
+
+  powerOn();
+  CHECK(boot([&]() {
+          std::vector<uint32_t> ids;
+
+          configure(thinning);
+          // only full segments are thinned, so this spans several of them
+          for (uint32_t n = 0; n < 900; n++) {
+            CHECK(append(n));
+          }
+          CHECK(CoolBacklog::getInstance().count() <= 400);
+          CHECK(pending(ids));
+          // older samples are thinned out, the latest ones are all kept
+          CHECK(ids.size() <= 400 && ids.back() == 899);
+          CHECK(ids.front() < 500);
+          for (size_t i = 1; i < ids.size(); i++) {
+            CHECK(ids[i] > ids[i - 1]);
+          }
+          return (0);
+        }) == 0);
+}
+
+int main() {
+  testAppend();
+  testCommit();
+  testCompress();
+  testCompact();
+  testStage();
+  testQuota();
+  return (0);
+}
@@ -0,0 +1,88 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// MQTT writes are batched into one client write, i.e. one TLS record
+
+#include "test.h"
+
+#include <Client.h>
+
+#include "CoolBatchClient.h"
+#include "CoolZ85.h"
+
+class Socket : public Client {
+
+public:
+  int connect(IPAddress, uint16_t) override { return (1); }
+  int connect(const char *, uint16_t) override { return (1); }
+  size_t write(uint8_t c) override { return (this->write(&c, 1)); }
+  size_t write(const uint8_t *data, size_t size) override {
+    this->writes++;
+    this->sent.write(data, size);
+    return (size);
+  }
+  int available() override { return (0); }
+  int read() override { return (-1); }
+  int read(uint8_t *, size_t) override { return (0); }
+  int peek() override { return (-1); }
+  void flush() override {}
+  void stop() override {}
+  uint8_t connected() override { return (1); }
+  operator bool() override { return (true); }
+
+  Buffer sent;
+  int writes = 0;
+};
+
+int main() {
+  Socket socket;
+  CoolBatchClient client(socket);
+  uint8_t payload[1000];
+
+  for (size_t i = 0; i < sizeof(payload); i++) {
+    payload[i] = i * 7;
+  }
+  // unbatched writes go straight through
+  client.write(payload, 10);
+  CHECK(socket.writes == 1 && socket.sent.size() == 10);
+
+  // a header, then Z85 text in 160-byte chunks, as PubSubClient sends it
+  size_t length = CoolZ85::encodedSize(sizeof(payload));
+  CHECK(client.hold(7 + length));
+  client.write(payload, 7);
+  CoolZ85 z85(client);
+  z85.write(payload, sizeof(payload));
+  CHECK(z85.end() == length && !z85.failed());
+  CHECK(socket.writes == 1);
+  CHECK(client.release());
+  CHECK(socket.writes == 2 && socket.sent.size() == 10 + 7 + length);
+  CHECK(!client.release());
+
+  // an overflowing batch is not sent at all
+  CHECK(client.hold(100));
+  CHECK(client.write(payload, 60) == 60);
+  CHECK(client.write(payload, 60) == 0);
+  CHECK(!client.release());
+  CHECK(socket.writes == 2);
+  return (0);
+}
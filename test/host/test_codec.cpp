@@ -0,0 +1,178 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// CRC32, Z85, LZSS and MessagePack framing
+
+#include "test.h"
+
+#include "CoolCrc32.h"
+#include "CoolLzss.h"
+#include "CoolMessagePack.h"
+#include "CoolZ85.h"
+#include "z85.h"
+
+static std::vector<uint8_t> random(size_t size, uint32_t seed) {
+  std::vector<uint8_t> data(size);
+
+  for (size_t i = 0; i < size; i++) {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+  }
+  return (data);
+}
+
+static void testCrc32() {
+  CHECK(CoolCrc32::update(0, "123456789", 9) == 0xcbf43926);
+  CHECK(CoolCrc32::update(CoolCrc32::update(0, "1234", 4), "56789", 5) ==
+        0xcbf43926);
+  CHECK(CoolCrc32::update(0, "", 0) == 0);
+}
+
+static void testZ85() {
+  const uint8_t hello[] = {0x86, 0x4f, 0xd2, 0x6f, 0xb5, 0x59, 0xf7, 0x5b};
+  Buffer bare;
+  Buffer quoted;
+  CoolZ85 z85Bare(bare, false);
+  CoolZ85 z85Quoted(quoted);
+
+  z85Bare.write(hello, sizeof(hello));
+  CHECK(z85Bare.end() == 10);
+  CHECK(memcmp(bare.data(), "HelloWorld", 10) == 0);
+  z85Quoted.write(hello, sizeof(hello));
+  CHECK(z85Quoted.end() == 12);
+  CHECK(memcmp(quoted.data(), "\"HelloWorld\"", 12) == 0);
+
+  for (size_t size = 0; size < 700; size += 13) {
+    std::vector<uint8_t> data = random(size, size);
+    std::vector<uint8_t> padded(data);
+    std::vector<char> encoded(CoolZ85::encodedSize(size));
+    Buffer streamed;
+    CoolZ85 z85(streamed);
+
+    // the last group is padded with zeros
+    padded.resize((size + 3) / 4 * 4);
+    size_t length = encoded.size();
+    encoded[0] = '"';
+    Z85_encode_unsafe((const char *)padded.data(),
+                      (const char *)padded.data() + padded.size(),
+                      encoded.data() + 1);
+    encoded[length - 1] = '"';
+    // odd write sizes cross both the group and the chunk boundaries
+    for (size_t offset = 0; offset < size; offset += 7) {
+      z85.write(data.data() + offset, min((size_t)7, size - offset));
+    }
+    CHECK(z85.end() == length);
+    CHECK(!z85.failed());
+    CHECK(streamed.size() == length);
+    CHECK(memcmp(streamed.data(), encoded.data(), length) == 0);
+
+    std::vector<char> decoded(length);
+    size_t symbols = length - 2;
+    CHECK(Z85_decode(encoded.data() + 1, decoded.data(), symbols) ==
+          (size + 3) / 4 * 4);
+    CHECK(memcmp(decoded.data(), data.data(), size) == 0);
+  }
+}
+
+static void testLzss() {
+  std::vector<uint8_t> output(4096);
+  std::vector<uint8_t> restored(4096);
+
+  std::vector<uint8_t> text(1500);
+  for (size_t i = 0; i < text.size(); i++) {
+    text[i] = "temperature humidity pressure "[i % 30];
+  }
+  size_t packed =
+      CoolLzss::compress(text.data(), text.size(), output.data(), 4096);
+  CHECK(packed > 0 && packed < text.size() / 4);
+  // the raw size comes from the block header, padding bits are not a match
+  CHECK(CoolLzss::decompress(output.data(), packed, restored.data(),
+                             text.size()) == text.size());
+  CHECK(memcmp(restored.data(), text.data(), text.size()) == 0);
+  CHECK(CoolLzss::decompress(output.data(), packed, restored.data(), 100) <=
+        100);
+  CHECK(CoolLzss::decompress(output.data(), packed / 2, restored.data(),
+                             text.size()) != text.size());
+
+  for (size_t size = 1; size < 2000; size += 97) {
+    std::vector<uint8_t> data = random(size, size * 7);
+
+    packed = CoolLzss::compress(data.data(), size, output.data(), 4096);
+    if (packed == 0) {
+      continue;
+    }
+    CHECK(CoolLzss::decompress(output.data(), packed, restored.data(), size) ==
+          size);
+    CHECK(memcmp(restored.data(), data.data(), size) == 0);
+  }
+  // random data does not shrink and must not overflow a tight output
+  std::vector<uint8_t> noise = random(600, 3);
+  CHECK(CoolLzss::compress(noise.data(), noise.size(), output.data(), 600) ==
+        0);
+}
+
+static void testMessagePack() {
+  const int32_t integers[] = {0,     1,      127,     128,     255,
+                              256,   65535,  65536,   -1,      -32,
+                              -33,   -128,   -129,    -32768,  -32769,
+                              70000, -70000, 2147483647};
+  Buffer out;
+
+  CoolMessagePack::writeMapHeader(out, 3);
+  CoolMessagePack::writeString(out, "integers");
+  CoolMessagePack::writeArrayHeader(out, 18);
+  for (int32_t value : integers) {
+    CoolMessagePack::writeInteger(out, value);
+  }
+  CoolMessagePack::writeString(out, "long");
+  CoolMessagePack::writeString(out, std::string(300, 'x').c_str());
+  CoolMessagePack::writeString(out, "flags");
+  CoolMessagePack::writeArrayHeader(out, 4);
+  CoolMessagePack::writeBool(out, true);
+  CoolMessagePack::writeBool(out, false);
+  CoolMessagePack::writeNil(out);
+  CoolMessagePack::writeFloat(out, 21.5);
+
+  CHECK(CoolMessagePack::objectSize(out.data(), out.size()) == out.size());
+  for (size_t size = 0; size < out.size(); size++) {
+    CHECK(CoolMessagePack::objectSize(out.data(), size) == 0);
+  }
+  // trailing bytes belong to the next object
+  out.write((uint8_t)0xc0);
+  CHECK(CoolMessagePack::objectSize(out.data(), out.size()) ==
+        out.size() - 1);
+
+  const uint8_t unknown[] = {0xc1};
+  CHECK(CoolMessagePack::objectSize(unknown, 1) == 0);
+  // an array header may not claim more children than there are bytes
+  const uint8_t huge[] = {0xdd, 0xff, 0xff, 0xff, 0xff, 0x01};
+  CHECK(CoolMessagePack::objectSize(huge, sizeof(huge)) == 0);
+}
+
+int main() {
+  testCrc32();
+  testZ85();
+  testLzss();
+  testMessagePack();
+  return (0);
+}
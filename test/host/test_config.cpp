@@ -0,0 +1,75 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// configuration files are parsed straight from the SPIFFS stream: the
+// heap used by a read is the tree of the file, without a copy of its text
+
+#include "test.h"
+
+#include "CoolConfig.h"
+
+#define CONFIG_FILE_SIZE 16384
+#define CONFIG_FILE_PATH "/actuators.json"
+
+int main() {
+  std::string text = "{\"actuators\":[";
+  char actuator[256];
+
+  for (int i = 0; text.size() < CONFIG_FILE_SIZE - sizeof(actuator); i++) {
+    snprintf(actuator, sizeof(actuator),
+             "%s{\"actif\":true,\"temporal\":false,\"inverted\":false,"
+             "\"sensor\":\"Temperature_%d\",\"type\":\"\",\"low\":{"
+             "\"range\":%d.5,\"time\":0,\"hour\":6,\"minute\":30},\"high\":{"
+             "\"range\":%d.5,\"time\":0,\"hour\":20,\"minute\":0}}",
+             i ? "," : "", i, i, i + 10);
+    text += actuator;
+  }
+  text += "]}";
+  host::files[CONFIG_FILE_PATH].assign(text.begin(), text.end());
+  CHECK(text.size() > CONFIG_FILE_SIZE - sizeof(actuator));
+
+  uint32_t heap = ESP.getFreeHeap();
+  {
+    CoolConfig config(CONFIG_FILE_PATH);
+
+    config.readFileAsJson();
+    uint32_t held = heap - ESP.getFreeHeap();
+    // one block sized for the whole tree, kept with the reader
+    CHECK(held > text.size() && held < 4 * text.size());
+    // the peak only adds the open file to it
+    CHECK(CoolConfig::peakHeap() >= held);
+    CHECK(CoolConfig::peakHeap() - held < 256);
+  }
+  CHECK(ESP.getFreeHeap() == heap);
+
+  // a missing file is not counted
+  uint32_t peak = CoolConfig::peakHeap();
+  {
+    CoolConfig config("/missing.json");
+
+    CHECK(!config.readFileAsJson());
+  }
+  CHECK(CoolConfig::peakHeap() == peak);
+  printf("  %u B file, %u B peak\n", (unsigned)text.size(), peak);
+  return (0);
+}
@@ -0,0 +1,238 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// cuts power after every single flash write of a backlog operation, then
+// checks on the next boot that no saved sample was lost, duplicated or
+// torn and that the backlog still takes new samples
+
+#include "backlog.h"
+
+#include <functional>
+
+#define BASELINE_IMAGE "build/baseline.img"
+#define DURABLE_IDS "build/durable.ids"
+#define NEW_SAMPLE 10000
+
+static const BacklogSettings PLAIN = {0, 0, EVICT_DROP_OLDEST, false, false};
+static const BacklogSettings PACKED = {0, 0, EVICT_DROP_OLDEST, true, false};
+static const BacklogSettings THINNED = {0, 300, EVICT_DOWNSAMPLE, false,
+                                        false};
+static const BacklogSettings STAGED = {0, 0, EVICT_DROP_OLDEST, false, true};
+
+struct Scenario {
+  const char *name;
+  BacklogSettings settings;
+  std::function<void()> setup;
+  std::function<void()> operation;
+  // samples that must survive a cut, and all samples that may be found
+  std::vector<uint32_t> kept;
+  std::vector<uint32_t> allowed;
+  // samples already in flash before the operation must survive too
+  bool durable;
+};
+
+static void consume(uint32_t records) {
+  CoolBacklog &backlog = CoolBacklog::getInstance();
+  CoolBacklogCursor cursor = backlog.head();
+  uint8_t *data;
+  size_t size;
+
+  for (uint32_t i = 0; i < records; i++) {
+    CHECK(backlog.read(cursor, data, size) && data != NULL);
+    free(data);
+  }
+  CHECK(backlog.commit(cursor));
+}
+
+static bool contains(const std::vector<uint32_t> &ids, uint32_t n) {
+  return (std::find(ids.begin(), ids.end(), n) != ids.end());
+}
+
+// samples of the baseline that are in flash, not only in RTC memory
+static std::vector<uint32_t> durable(const Scenario &scenario) {
+  std::vector<uint32_t> ids;
+  uint32_t n;
+
+  CHECK(host::load(BASELINE_IMAGE));
+  ESP.powerOn();
+  CHECK(host::save(TEST_IMAGE));
+  CHECK(boot([&]() {
+          FILE *f = fopen(DURABLE_IDS, "wb");
+
+          configure(scenario.settings);
+          CHECK(f != NULL && pending(ids));
+          CHECK(fwrite(ids.data(), sizeof(n), ids.size(), f) == ids.size());
+          fclose(f);
+          return (0);
+        }) == 0);
+  FILE *f = fopen(DURABLE_IDS, "rb");
+  CHECK(f != NULL);
+  while (fread(&n, sizeof(n), 1, f) == 1) {
+    ids.push_back(n);
+  }
+  fclose(f);
+  return (ids);
+}
+
+static void check(const Scenario &scenario, long cut) {
+  int status = boot([&]() {
+    std::vector<uint32_t> ids;
+
+    configure(scenario.settings);
+    if (!pending(ids)) {
+      fprintf(stderr, "%s: damaged record after cut %ld\n", scenario.name,
+              cut);
+      return (1);
+    }
+    for (size_t i = 0; i < ids.size(); i++) {
+      if ((i > 0 && ids[i] <= ids[i - 1]) ||
+          !contains(scenario.allowed, ids[i])) {
+        fprintf(stderr, "%s: sample %u out of place after cut %ld\n",
+                scenario.name, ids[i], cut);
+        return (1);
+      }
+    }
+    for (uint32_t n : scenario.kept) {
+      if (!contains(ids, n)) {
+        fprintf(stderr, "%s: sample %u lost after cut %ld\n", scenario.name,
+                n, cut);
+        return (1);
+      }
+    }
+    CHECK(append(NEW_SAMPLE));
+    CoolBacklog::getInstance().flush();
+    CHECK(pending(ids) && !ids.empty() && ids.back() == NEW_SAMPLE);
+    return (0);
+  });
+  CHECK(status == 0);
+}
+
+static void run(Scenario scenario) {
+  long cuts = 0;
+
+  powerOn();
+  CHECK(boot([&]() {
+          configure(scenario.settings);
+          scenario.setup();
+          ESP.deepSleepWake();
+          return (0);
+        }) == 0);
+  CHECK(host::load(TEST_IMAGE) && host::save(BASELINE_IMAGE));
+  if (scenario.durable) {
+    scenario.kept = durable(scenario);
+    CHECK(!scenario.kept.empty());
+  }
+  // one more write each time, until the operation runs to the end
+  for (long cut = 0;; cut++) {
+    CHECK(host::load(BASELINE_IMAGE) && host::save(TEST_IMAGE));
+    int status = boot([&]() {
+      configure(scenario.settings);
+      host::cutAfter(cut);
+      scenario.operation();
+      host::disarm();
+      ESP.powerOn();
+      return (0);
+    });
+    CHECK(status == 0 || status == POWER_CUT);
+    check(scenario, cut);
+    if (status == 0) {
+      break;
+    }
+    cuts++;
+  }
+  printf("  %s: %ld power cuts, %zu samples kept\n", scenario.name, cuts,
+         scenario.kept.size());
+  CHECK(cuts > 0);
+}
+
+int main() {
+  // the tail segment fills up and a new one is started
+  run({"append",
+       PLAIN,
+       []() {
+         for (uint32_t n = 0; n < 140; n++) {
+           CHECK(append(n));
+         }
+       },
+       []() {
+         for (uint32_t n = 140; n < 160; n++) {
+           append(n);
+         }
+       },
+       range(0, 140), range(0, 160), false});
+
+  // the first segment is deleted and a record is marked as sent
+  run({"commit",
+       PLAIN,
+       []() {
+         for (uint32_t n = 0; n < 300; n++) {
+           CHECK(append(n));
+         }
+       },
+       []() { consume(200); }, range(200, 300), range(0, 300), false});
+
+  // the mostly sent head segment is rewritten without its sent records,
+  // then every full segment is packed into compressed blocks
+  run({"compact",
+       PACKED,
+       []() {
+         for (uint32_t n = 0; n < 400; n++) {
+           CHECK(append(n));
+         }
+         consume(120);
+       },
+       []() { CoolBacklog::getInstance().compact(); }, range(120, 400),
+       range(120, 400), false});
+
+  // over quota, full segments are thinned to every other sample
+  run({"downsample",
+       THINNED,
+       []() {
+         for (uint32_t n = 0; n < 300; n++) {
+           CHECK(append(n));
+         }
+       },
+       []() {
+         for (uint32_t n = 300; n < 320; n++) {
+           append(n);
+         }
+       },
+       {}, range(0, 320), false});
+
+  // samples staged in RTC memory are lost with it, flash must stay whole
+  run({"stage",
+       STAGED,
+       []() {
+         for (uint32_t n = 0; n < 200; n++) {
+           CHECK(append(n));
+         }
+       },
+       []() {
+         for (uint32_t n = 200; n < 260; n++) {
+           append(n);
+         }
+         CoolBacklog::getInstance().flush();
+       },
+       {}, range(0, 260), true});
+  return (0);
+}
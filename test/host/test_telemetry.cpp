@@ -0,0 +1,207 @@
+/**
+ *  Copyright (c) 2018 La Cool Co SAS
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a
+ *  copy of this software and associated documentation files (the "Software"),
+ *  to deal in the Software without restriction, including without limitation
+ *  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ *  and/or sell copies of the Software, and to permit persons to whom the
+ *  Software is furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included
+ *  in all copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ *  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ *  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ *  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ *  IN THE SOFTWARE.
+ *
+ */
+
+// streaming telemetry writer, compact key schema and sample frames
+
+#include "test.h"
+
+#include "CoolFrame.h"
+#include "CoolSchema.h"
+#include "CoolSnapshot.h"
+#include "CoolTelemetry.h"
+#include "CoolZ85.h"
+
+static void testTelemetry() {
+  CoolTelemetry telemetry;
+  char key[8];
+
+  telemetry.beginObject();
+  telemetry.add("temperature", 21.5);
+  telemetry.add("count", (uint16_t)300);
+  telemetry.add("text", "hello");
+  telemetry.addNull("none");
+  telemetry.beginArray("values");
+  for (int i = 0; i < 20; i++) {
+    telemetry.add(NULL, i * 1000);
+  }
+  telemetry.endArray();
+  telemetry.beginObject("many");
+  for (int i = 0; i < 20; i++) {
+    snprintf(key, sizeof(key), "k%d", i);
+    telemetry.add(key, true);
+  }
+  telemetry.endObject();
+  // the last value of a repeated key wins, as it did in a JsonObject
+  telemetry.add("temperature", 22.5);
+  telemetry.endObject();
+
+  CHECK(!telemetry.failed());
+  CHECK(CoolMessagePack::objectSize(telemetry.data(), telemetry.size()) ==
+        telemetry.size());
+  CHECK(telemetry.data()[0] == 0x86);
+  const uint8_t last[] = {0xab, 't', 'e', 'm', 'p', 'e', 'r', 'a', 't',
+                          'u',  'r', 'e', 0xca, 0x41, 0xb4, 0x00, 0x00};
+  CHECK(memcmp(telemetry.data() + telemetry.size() - sizeof(last), last,
+               sizeof(last)) == 0);
+
+  CoolTelemetry unbalanced;
+  unbalanced.beginObject();
+  unbalanced.endArray();
+  CHECK(unbalanced.failed());
+}
+
+static void restoreSchema(bool active, const char *key) {
+  CoolSnapshot saved;
+  CoolSnapshot loaded;
+
+  saved.put(active);
+  saved.put((uint8_t)(key ? 1 : 0));
+  if (key) {
+    saved.put(String(key));
+  }
+  CHECK(saved.save(1));
+  CHECK(loaded.load(1));
+  CHECK(CoolSchema::getInstance().restore(loaded));
+}
+
+static void testSchema() {
+  CoolSchema &schema = CoolSchema::getInstance();
+  CoolTelemetry telemetry;
+
+  restoreSchema(false, NULL);
+  CHECK(!schema.isActive());
+  CHECK(schema.id("state") == -1);
+
+  restoreSchema(true, "CO2");
+  CHECK(schema.isActive());
+  CHECK(schema.id("state") == 0);
+  CHECK(schema.id("boot") == 49);
+  CHECK(schema.id("CO2") == 50);
+  CHECK(schema.id("unknown") == -1);
+  uint32_t hash = schema.hash();
+
+  restoreSchema(true, "NO2");
+  CHECK(schema.id("CO2") == -1);
+  CHECK(schema.hash() != hash);
+
+  telemetry.setSchema(&schema);
+  telemetry.beginObject();
+  telemetry.add("temperature", 20);
+  telemetry.add("unknown", 1);
+  telemetry.endObject();
+  const uint8_t expected[] = {0x82, 27,  20,  0xa7, 'u', 'n',
+                              'k',  'n', 'o', 'w',  'n', 1};
+  CHECK(telemetry.size() == sizeof(expected));
+  CHECK(memcmp(telemetry.data(), expected, sizeof(expected)) == 0);
+
+  CoolSnapshot saved;
+  CoolSnapshot loaded;
+  schema.snapshot(saved);
+  CHECK(saved.save(2) && loaded.load(2));
+  hash = schema.hash();
+  restoreSchema(false, NULL);
+  CHECK(schema.restore(loaded));
+  CHECK(schema.hash() == hash && schema.id("NO2") == 50);
+
+  // the key tables only take heap while compact keys are active
+  restoreSchema(false, NULL);
+  uint32_t heap = ESP.getFreeHeap();
+  restoreSchema(true, "NO2");
+  CHECK(heap - ESP.getFreeHeap() >= sizeof(CoolSchemaTables));
+  restoreSchema(false, NULL);
+  CHECK(ESP.getFreeHeap() == heap);
+}
+
+static void testFrame() {
+  CoolTelemetry sample;
+  CoolTelemetry record;
+
+  restoreSchema(false, NULL);
+  sample.beginObject();
+  sample.add("temperature", 20);
+  sample.endObject();
+  record.beginObject();
+  record.beginObject("state");
+  record.endObject();
+  record.endObject();
+  CHECK(CoolFrame::isSample(sample.data(), sample.size()));
+  CHECK(!CoolFrame::isSample(record.data(), record.size()));
+
+  CoolFrame frame(256, false);
+  frame.begin("00:11:22:33:44:55");
+  uint8_t added = 0;
+  while (frame.add(sample.data(), sample.size())) {
+    added++;
+  }
+  frame.end();
+  CHECK(added > 1 && frame.count() == added);
+  CHECK(!frame.failed() && frame.size() <= 256);
+  CHECK(CoolMessagePack::objectSize(frame.data(), frame.size()) ==
+        frame.size());
+
+  CoolFrame armored(256);
+  armored.begin("00:11:22:33:44:55");
+  while (armored.add(sample.data(), sample.size())) {
+  }
+  armored.end();
+  CHECK(armored.count() < frame.count());
+  CHECK(CoolZ85::encodedSize(armored.size()) <= 256);
+
+  // saved samples carry their own firmware version and schema
+  CoolTelemetry stamped;
+  CHECK(CoolFrame::stamp(stamped, sample.data(), sample.size()));
+  const uint8_t version[] = {0xa9, 'f', 'w', 'V', 'e', 'r', 's', 'i',
+                             'o',  'n', 0xa4, 'h', 'o', 's', 't'};
+  CHECK(stamped.data()[0] == 0x82);
+  CHECK(stamped.size() == sample.size() + sizeof(version));
+  CHECK(memcmp(stamped.data() + sample.size(), version, sizeof(version)) ==
+        0);
+  CHECK(CoolFrame::isSample(stamped.data(), stamped.size()));
+  CHECK(!CoolFrame::stamp(stamped, record.data(), record.size()));
+
+  restoreSchema(true, "CO2");
+  uint32_t hash = CoolSchema::getInstance().hash();
+  CoolTelemetry keyed;
+  CoolTelemetry compact;
+  keyed.setSchema(&CoolSchema::getInstance());
+  keyed.beginObject();
+  keyed.add("temperature", 20);
+  keyed.endObject();
+  CHECK(CoolFrame::stamp(compact, keyed.data(), keyed.size()));
+  const uint8_t schema[] = {7,  0xa4, 'h', 'o', 's', 't', 9,
+                            0xce, (uint8_t)(hash >> 24), (uint8_t)(hash >> 16),
+                            (uint8_t)(hash >> 8), (uint8_t)hash};
+  CHECK(compact.data()[0] == 0x83);
+  CHECK(compact.size() == keyed.size() + sizeof(schema));
+  CHECK(memcmp(compact.data() + keyed.size(), schema, sizeof(schema)) == 0);
+  CHECK(CoolMessagePack::objectSize(compact.data(), compact.size()) ==
+        compact.size());
+}
+
+int main() {
+  powerOn();
+  testTelemetry();
+  testSchema();
+  testFrame();
+  return (0);
+}